@@ -0,0 +1,19 @@
+#version 450 core
+
+in vec2 TexCoords;
+in vec3 SpriteColor;
+
+out vec4 color;
+
+// Single channel distance field, 0.5 on the glyph outline.
+uniform sampler2D image;
+
+void main() {
+    float distance = texture(image, TexCoords).r;
+
+    // Anti-alias over roughly one screen pixel, whatever scale the glyph is drawn at.
+    float smoothing = 0.7 * length(vec2(dFdx(distance), dFdy(distance)));
+    float alpha = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);
+
+    color = vec4(SpriteColor, alpha);
+}
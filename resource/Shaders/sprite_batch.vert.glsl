@@ -0,0 +1,22 @@
+#version 450 core
+
+// xy = position in world space, zw = texture coordinates.
+layout (location = 0) in vec4 vertex;
+layout (location = 1) in vec3 vertex_color;
+
+out vec2 TexCoords;
+out vec3 SpriteColor;
+
+// Per-frame constants shared by every program, see FrameConstants.hpp.
+layout (std140, binding = 0) uniform FrameConstants {
+    mat4 projection;
+    mat4 view;
+    vec4 viewport; // xy = size in pixels, zw = 1 / size
+    float time;    // seconds
+};
+
+void main() {
+    TexCoords = vertex.zw;
+    SpriteColor = vertex_color;
+    gl_Position = projection * view * vec4(vertex.xy, 0.0, 1.0);
+}
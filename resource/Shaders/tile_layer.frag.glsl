@@ -0,0 +1,13 @@
+#version 450 core
+
+in vec2 TexCoords;
+flat in uint Layer;
+
+out vec4 color;
+
+uniform sampler2DArray texarray;
+uniform vec3 spriteColor;
+
+void main() {
+    color = vec4(spriteColor, 1.0) * texture(texarray, vec3(TexCoords, float(Layer)));
+}
@@ -0,0 +1,40 @@
+#version 450 core
+
+// Per-vertex unit quad: xy = position, zw = texture coordinates.
+layout (location = 0) in vec4 vertex;
+
+// Per-instance tile data.
+layout (location = 1) in uvec2 tile_position;
+layout (location = 2) in uvec2 tile_data; // x = array layer, y = flip bits
+
+out vec2 TexCoords;
+flat out uint Layer;
+
+// Per-frame constants shared by every program, see FrameConstants.hpp.
+layout (std140, binding = 0) uniform FrameConstants {
+    mat4 projection;
+    mat4 view;
+    vec4 viewport; // xy = size in pixels, zw = 1 / size
+    float time;    // seconds
+};
+
+uniform vec2 origin;
+uniform float tile_size;
+
+void main() {
+    vec2 tex_coords = vertex.zw;
+
+    if((tile_data.y & 1u) != 0u) {
+        tex_coords.x = 1.0 - tex_coords.x;
+    }
+
+    if((tile_data.y & 2u) != 0u) {
+        tex_coords.y = 1.0 - tex_coords.y;
+    }
+
+    TexCoords = tex_coords;
+    Layer = tile_data.x;
+
+    vec2 position = origin + (vec2(tile_position) + vertex.xy) * tile_size;
+    gl_Position = projection * view * vec4(position, 0.0, 1.0);
+}
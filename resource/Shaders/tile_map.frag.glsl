@@ -0,0 +1,47 @@
+#version 450 core
+
+in vec2 MapCoords;
+
+out vec4 color;
+
+layout (binding = 0) uniform sampler2DArray texarray;
+layout (binding = 1) uniform usampler2D tilemap;
+uniform vec3 spriteColor;
+
+// Variants: ALPHA_TEST keeps only opaque pixels, TRANSLUCENT_ONLY only partially transparent ones.
+
+void main() {
+    ivec2 cell = clamp(ivec2(floor(MapCoords)), ivec2(0), textureSize(tilemap, 0) - 1);
+    uint value = texelFetch(tilemap, cell, 0).r;
+
+    // Low 14 bits are the tileset index, top two bits are the flip bits.
+    uint layer = value & 0x3FFFu;
+
+    if(layer == 0u) {
+        discard;
+    }
+
+    vec2 tex_coords = fract(MapCoords);
+
+    if((value & 0x4000u) != 0u) {
+        tex_coords.x = 1.0 - tex_coords.x;
+    }
+
+    if((value & 0x8000u) != 0u) {
+        tex_coords.y = 1.0 - tex_coords.y;
+    }
+
+    vec4 texel = texture(texarray, vec3(tex_coords, float(layer)));
+
+#if defined(ALPHA_TEST)
+    if(texel.a < 1.0) {
+        discard;
+    }
+#elif defined(TRANSLUCENT_ONLY)
+    if(texel.a >= 1.0 || texel.a <= 0.0) {
+        discard;
+    }
+#endif
+
+    color = vec4(spriteColor, 1.0) * texel;
+}
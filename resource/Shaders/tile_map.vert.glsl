@@ -0,0 +1,26 @@
+#version 450 core
+
+// Per-vertex unit quad: xy = position, zw = texture coordinates.
+layout (location = 0) in vec4 vertex;
+
+// Position within the layer, measured in tiles.
+out vec2 MapCoords;
+
+// Per-frame constants shared by every program, see FrameConstants.hpp.
+layout (std140, binding = 0) uniform FrameConstants {
+    mat4 projection;
+    mat4 view;
+    vec4 viewport; // xy = size in pixels, zw = 1 / size
+    float time;    // seconds
+};
+
+uniform vec2 origin;
+uniform vec4 tile_range; // xy = first tile, zw = tile count
+uniform float tile_size;
+
+void main() {
+    MapCoords = tile_range.xy + vertex.xy * tile_range.zw;
+
+    vec2 position = origin + MapCoords * tile_size;
+    gl_Position = projection * view * vec4(position, 0.0, 1.0);
+}
@@ -0,0 +1,45 @@
+#version 450 core
+
+// Per-vertex unit quad: xy = position, zw = texture coordinates.
+layout (location = 0) in vec4 vertex;
+
+// Per-instance tile data.
+layout (location = 1) in vec2 tile_position; // top left corner in world space
+layout (location = 2) in uint tile_layer;    // tileset array layer
+layout (location = 3) in uvec2 tile_data;    // x = flip bits, y = depth slot
+
+out vec2 TexCoords;
+flat out uint Layer;
+
+// Per-frame constants shared by every program, see FrameConstants.hpp.
+layout (std140, binding = 0) uniform FrameConstants {
+    mat4 projection;
+    mat4 view;
+    vec4 viewport; // xy = size in pixels, zw = 1 / size
+    float time;    // seconds
+};
+
+uniform float tile_size;
+uniform float depth;      // window depth of depth slot 0
+uniform float depth_step; // each following slot is this much nearer
+
+void main() {
+    vec2 tex_coords = vertex.zw;
+
+    if((tile_data.x & 1u) != 0u) {
+        tex_coords.x = 1.0 - tex_coords.x;
+    }
+
+    if((tile_data.x & 2u) != 0u) {
+        tex_coords.y = 1.0 - tex_coords.y;
+    }
+
+    TexCoords = tex_coords;
+    Layer = tile_layer;
+
+    vec2 position = tile_position + vertex.xy * tile_size;
+    gl_Position = projection * view * vec4(position, 0.0, 1.0);
+
+    // One draw covers every layer, so depth comes from the slot instead of glDepthRange.
+    gl_Position.z = (2.0 * (depth - float(tile_data.y) * depth_step) - 1.0) * gl_Position.w;
+}
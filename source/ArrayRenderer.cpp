@@ -26,15 +26,21 @@
 #include <glm/ext.hpp>
 
 #include "ArrayRenderer.hpp"
+#include "RenderState.hpp"
 #include "Shader.hpp"
 
 ArrayRenderer::ArrayRenderer(Shader& shader) : shader(shader) {
+	uniform_diffuse_layer_max = this->shader.GetUniform<unsigned int>("diffuse_layer_max");
+	uniform_diffuse_layer     = this->shader.GetUniform<unsigned int>("diffuse_layer");
+	uniform_model             = this->shader.GetUniform<glm::mat4>("model");
+	uniform_sprite_color      = this->shader.GetUniform<glm::vec3>("spriteColor");
+
 	InitRenderData();
 }
 
 ArrayRenderer::~ArrayRenderer() {
-	glDeleteVertexArrays(1, &quad_vao);
-	glDeleteBuffers(1, &quad_vbo);
+	RenderState::DeleteVertexArray(quad_vao);
+	RenderState::DeleteBuffer(quad_vbo);
 }
 
 void ArrayRenderer::DrawArray(Texture2D& texture, std::uint32_t layer, glm::vec2 position, glm::vec2 size, float rotation, glm::vec3 color) {
@@ -68,15 +74,15 @@ void ArrayRenderer::DrawArray(Texture2D& texture, std::uint32_t layer, glm::vec2
 
 	model = glm::scale(model, glm::vec3(size, 1.0f));
 
-	shader.SetIntegerUnsigned("diffuse_layer_max", texture.GetSubImageCount());
-	shader.SetIntegerUnsigned("diffuse_layer", layer);
-	shader.SetMatrix4f("model", model);
-	shader.SetVector3f("spriteColor", color);
+	shader.Set(uniform_diffuse_layer_max, texture.GetSubImageCount());
+	shader.Set(uniform_diffuse_layer, layer);
+	shader.Set(uniform_model, model);
+	shader.Set(uniform_sprite_color, color);
 
 	texture.Bind();
 
 	// Draw the QuadVAO and then bind nothing.
-	glBindVertexArray(quad_vao);
+	RenderState::BindVertexArray(quad_vao);
 	glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
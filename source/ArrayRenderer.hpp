@@ -36,8 +36,15 @@ class ArrayRenderer {
 
 		void DrawArray(Texture2D& texture, std::uint32_t layer, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f), float rotation = 0.0f, glm::vec3 color = glm::vec3(1.0f));
 
+		std::uint32_t GetShaderID() { return static_cast<std::uint32_t>(shader.GetID()); }
+
 	private:
 		Shader shader;
+		ShaderUniform<unsigned int> uniform_diffuse_layer_max;
+		ShaderUniform<unsigned int> uniform_diffuse_layer;
+		ShaderUniform<glm::mat4>    uniform_model;
+		ShaderUniform<glm::vec3>    uniform_sprite_color;
+
 		std::uint32_t quad_vao;
 		std::uint32_t quad_vbo;
 
@@ -0,0 +1,88 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "Camera.hpp"
+#include "GameMapLayer.hpp"
+
+// Keep zoom away from zero, the projection would degenerate.
+static const float minimum_zoom = 0.125f;
+
+Camera::Camera() : position(0.0f), viewport(0.0f), zoom(1.0f) {
+
+}
+
+Camera::Camera(float viewport_width, float viewport_height) : position(0.5f * viewport_width, 0.5f * viewport_height), viewport(viewport_width, viewport_height), zoom(1.0f) {
+
+}
+
+void Camera::SetZoom(float zoom) {
+	this->zoom = std::max(zoom, minimum_zoom);
+}
+
+glm::vec2 Camera::GetVisibleMin() {
+	glm::vec2 visible_min = position - (0.5f * viewport / zoom);
+
+	// Snap to whole screen pixels.
+	return glm::floor(visible_min * zoom) / zoom;
+}
+
+glm::vec2 Camera::GetVisibleMax() {
+	return GetVisibleMin() + (viewport / zoom);
+}
+
+glm::mat4 Camera::GetProjection() {
+	return glm::ortho(0.0f, viewport.x, viewport.y, 0.0f, -1.0f, 1.0f);
+}
+
+glm::mat4 Camera::GetView() {
+	glm::mat4 view = glm::scale(glm::mat4(1.0f), glm::vec3(zoom, zoom, 1.0f));
+
+	return glm::translate(view, glm::vec3(-GetVisibleMin(), 0.0f));
+}
+
+TileRange Camera::GetVisibleTiles(GameMapLayer& layer, glm::vec2 layer_origin) {
+
+	TileRange range = { 0, 0, 0, 0 };
+
+	if(layer.GetTileSize() <= 0) {
+		return range;
+	}
+
+	float tile_size = static_cast<float>(layer.GetTileSize());
+
+	glm::vec2 first = glm::floor((GetVisibleMin() - layer_origin) / tile_size);
+	glm::vec2 last = glm::ceil((GetVisibleMax() - layer_origin) / tile_size);
+
+	float width = static_cast<float>(layer.GetWidthTiles());
+	float height = static_cast<float>(layer.GetHeightTiles());
+
+	range.x_begin = static_cast<std::uint32_t>(glm::clamp(first.x, 0.0f, width));
+	range.y_begin = static_cast<std::uint32_t>(glm::clamp(first.y, 0.0f, height));
+	range.x_end = static_cast<std::uint32_t>(glm::clamp(last.x, 0.0f, width));
+	range.y_end = static_cast<std::uint32_t>(glm::clamp(last.y, 0.0f, height));
+
+	return range;
+}
\ No newline at end of file
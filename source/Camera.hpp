@@ -0,0 +1,78 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CAMERA_HPP__
+#define __CAMERA_HPP__
+
+// STL
+#include <cstdint>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "GameMapLayer.hpp"
+
+// Half open range of tiles, [x_begin, x_end) by [y_begin, y_end).
+struct TileRange {
+	std::uint32_t x_begin, y_begin;
+	std::uint32_t x_end, y_end;
+
+	bool IsEmpty() const { return x_begin >= x_end || y_begin >= y_end; }
+};
+
+/**
+ * 2D orthographic camera.
+ *
+ * position is the world point at the center of the viewport, zoom is screen pixels
+ * per world unit. The visible area is snapped to whole screen pixels so tiles don't
+ * shimmer while the camera moves.
+ */
+class Camera {
+
+	public:
+		Camera();
+		Camera(float viewport_width, float viewport_height);
+
+		void SetPosition(glm::vec2 position) { this->position = position; }
+		void Move(glm::vec2 offset) { position += offset; }
+		void SetZoom(float zoom);
+		void SetViewport(float viewport_width, float viewport_height) { viewport = glm::vec2(viewport_width, viewport_height); }
+
+		glm::vec2 GetPosition() { return position; }
+		float GetZoom() { return zoom; }
+		glm::vec2 GetViewport() { return viewport; }
+
+		// Viewport pixels to clip space, GetProjection() * GetView() takes the world to clip space.
+		glm::mat4 GetProjection();
+		// World to viewport pixels.
+		glm::mat4 GetView();
+
+		// World space corners of the visible area.
+		glm::vec2 GetVisibleMin();
+		glm::vec2 GetVisibleMax();
+
+		// Tiles of a layer drawn at layer_origin that intersect the visible area, clamped to the layer.
+		TileRange GetVisibleTiles(GameMapLayer& layer, glm::vec2 layer_origin = glm::vec2(0.0f));
+
+	private:
+		glm::vec2 position;
+		glm::vec2 viewport;
+		float zoom;
+};
+
+#endif /* __CAMERA_HPP__ */
\ No newline at end of file
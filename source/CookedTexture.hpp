@@ -0,0 +1,90 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __COOKED_TEXTURE_HPP__
+#define __COOKED_TEXTURE_HPP__
+
+// STL
+#include <cstdint>
+#include <string>
+
+// POSIX, also provided by the Windows CRT
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/*
+ * Layout of a cooked texture file (*.mtex), written by the mattRPG_cooker tool and
+ * read straight from a memory mapping by ResourceLoader.
+ *
+ * The header is followed by data_size bytes of pixels at data_offset, ready for
+ * glTextureSubImage2D/3D. Array textures store their layers one after another, each
+ * layer one tile of the source sheet in row-major tile order.
+ *
+ * If internal_format is block compressed (BC7 from the cooker, BC1 is also accepted) the
+ * data is 4x4 blocks for glCompressedTextureSubImage2D/3D and image_type is 0.
+ *
+ * Cooked files sit next to their source image, "image.png" cooks to "image.png.mtex".
+ * The source's size and modification time are stored with it, a cooked file whose
+ * source has changed since is stale and the source is decoded instead.
+ */
+
+// "MTEX" in file byte order.
+static const std::uint32_t cooked_texture_magic = 0x5845544D;
+static const std::uint32_t cooked_texture_version = 2;
+
+struct CookedTextureHeader {
+	std::uint32_t magic;
+	std::uint32_t version;
+
+	// GL internal format and the format/type the pixel data is in.
+	std::uint32_t internal_format;
+	std::uint32_t image_format;
+	std::uint32_t image_type;
+
+	// Dimensions of the source image.
+	std::uint32_t source_width;
+	std::uint32_t source_height;
+
+	// Dimensions of one layer, layer_count is 0 for a plain 2D texture.
+	std::uint32_t layer_width;
+	std::uint32_t layer_height;
+	std::uint32_t layer_count;
+
+	std::uint64_t data_offset;
+	std::uint64_t data_size;
+
+	// Size and modification time of the source image when it was cooked.
+	std::uint64_t source_size;
+	std::int64_t source_modified_time;
+};
+
+// Size and modification time of a source image, false if it can't be read.
+static inline bool GetCookedTextureSourceStamp(const std::string& filename, std::uint64_t& size, std::int64_t& modified_time) {
+
+	struct stat file_status;
+
+	if(stat(filename.c_str(), &file_status) != 0) {
+		return false;
+	}
+
+	size = static_cast<std::uint64_t>(file_status.st_size);
+	modified_time = static_cast<std::int64_t>(file_status.st_mtime);
+
+	return true;
+}
+
+#endif /* __COOKED_TEXTURE_HPP__ */
\ No newline at end of file
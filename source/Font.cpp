@@ -74,6 +74,9 @@ void Font::Draw(SpriteRenderer* renderer, const char* text, int position_x, int
 
 	renderer->DrawSprite(texture, glm::vec2(position_x, position_y), glm::vec2(texture.GetWidth(), texture.GetHeight()));
 
+	// The texture is deleted right away, so a batching renderer has to draw it first.
+	renderer->Flush();
+
 	texture.Delete();
 }
 
@@ -0,0 +1,101 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// GLAD2
+#include <glad/gl.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+#include "FrameConstants.hpp"
+#include "RenderState.hpp"
+
+FrameConstants::FrameConstants() : buffer_id(0), block_stride(0) {
+
+	for(auto& fallback_projection : fallback_projections) {
+		fallback_projection = glm::mat4(1.0f);
+	}
+
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+	if(alignment <= 0) {
+		alignment = 256;
+	}
+
+	std::uint32_t block_alignment = static_cast<std::uint32_t>(alignment);
+	block_stride = ((static_cast<std::uint32_t>(sizeof(Block)) + block_alignment - 1) / block_alignment) * block_alignment;
+
+	glCreateBuffers(1, &buffer_id);
+	glNamedBufferStorage(buffer_id, block_stride * space_count, nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+FrameConstants::~FrameConstants() {
+	RenderState::DeleteBuffer(buffer_id);
+}
+
+void FrameConstants::Update(const glm::mat4& projection, const glm::mat4& view, glm::vec2 viewport, float time) {
+
+	std::vector<std::uint8_t> data(block_stride * space_count, 0);
+
+	Block block = { };
+	block.projection = projection;
+	block.view = view;
+	block.viewport = glm::vec4(viewport.x, viewport.y, 1.0f / std::max(viewport.x, 1.0f), 1.0f / std::max(viewport.y, 1.0f));
+	block.time = time;
+
+	std::memcpy(data.data() + block_stride * static_cast<std::uint32_t>(FrameSpace::World), &block, sizeof(Block));
+
+	block.view = glm::mat4(1.0f);
+
+	std::memcpy(data.data() + block_stride * static_cast<std::uint32_t>(FrameSpace::Screen), &block, sizeof(Block));
+
+	glNamedBufferSubData(buffer_id, 0, data.size(), data.data());
+
+	fallback_projections[static_cast<std::uint32_t>(FrameSpace::World)] = projection * view;
+	fallback_projections[static_cast<std::uint32_t>(FrameSpace::Screen)] = projection;
+}
+
+void FrameConstants::Bind(FrameSpace space) {
+	RenderState::BindBufferRange(GL_UNIFORM_BUFFER, binding, buffer_id, block_stride * static_cast<std::uint32_t>(space), sizeof(Block));
+
+	// Written with the program's shadow value, so only a changed matrix is uploaded.
+	for(auto& fallback_shader : fallback_shaders) {
+		fallback_shader.shader.Set(fallback_shader.projection, fallback_projections[static_cast<std::uint32_t>(space)]);
+	}
+}
+
+void FrameConstants::AddFallbackShader(Shader shader) {
+
+	if(shader.GetUniformBlock("FrameConstants") != nullptr) {
+		return;
+	}
+
+	ShaderUniform<glm::mat4> projection = shader.GetUniform<glm::mat4>("projection");
+
+	if(projection.IsValid() == false) {
+		return;
+	}
+
+	fallback_shaders.push_back({ shader, projection });
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FRAME_CONSTANTS_HPP__
+#define __FRAME_CONSTANTS_HPP__
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+#include "Shader.hpp"
+
+// Which set of frame constants the next draws use.
+enum class FrameSpace : std::uint8_t {
+	World,  // Through the camera.
+	Screen  // Window pixels, for the UI.
+};
+
+/**
+ * Uniform buffer with the constants every shader shares for a frame.
+ *
+ * Shaders declare the FrameConstants block below at binding point FrameConstants::binding,
+ * so nothing is uploaded per program. Update() writes a block for each FrameSpace in one
+ * upload, once per frame, and Bind() switches between them by binding a range.
+ *
+ *     layout (std140, binding = 0) uniform FrameConstants {
+ *         mat4 projection;
+ *         mat4 view;
+ *         vec4 viewport; // xy = size in pixels, zw = 1 / size
+ *         float time;    // seconds
+ *     };
+ *
+ * Programs that don't declare the block yet can be added with AddFallbackShader(), they
+ * get projection * view of the bound space through a "projection" uniform on every Bind().
+ */
+class FrameConstants {
+
+	public:
+		static const std::uint32_t binding = 0;
+
+		FrameConstants();
+		~FrameConstants();
+
+		// view is the world view, the screen space block uses identity.
+		void Update(const glm::mat4& projection, const glm::mat4& view, glm::vec2 viewport, float time);
+		void Bind(FrameSpace space);
+
+		// Only kept if the program lacks the block and has a "projection" uniform.
+		void AddFallbackShader(Shader shader);
+
+		std::uint32_t GetID() { return buffer_id; }
+
+	private:
+		// Matches the std140 layout of the block.
+		struct Block {
+			glm::mat4 projection;
+			glm::mat4 view;
+			glm::vec4 viewport;
+			float time;
+			float padding[3];
+		};
+
+		static const std::uint32_t space_count = 2;
+
+		struct FallbackShader {
+			Shader shader;
+			ShaderUniform<glm::mat4> projection;
+		};
+
+		std::uint32_t buffer_id;
+
+		// Size of a block rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+		std::uint32_t block_stride;
+
+		std::vector<FallbackShader> fallback_shaders;
+
+		// projection * view of every space from the last Update(), for the fallback shaders.
+		glm::mat4 fallback_projections[space_count];
+};
+
+#endif /* __FRAME_CONSTANTS_HPP__ */
\ No newline at end of file
@@ -0,0 +1,259 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// GLAD2
+#include <glad/gl.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// SDL2
+#include "SDL.h"
+
+#include "FrameProfiler.hpp"
+#include "SDFFont.hpp"
+#include "SpriteRenderer.hpp"
+#include "TextRenderer.hpp"
+#include "Texture2D.hpp"
+
+// Graph size in pixels, the full height is two 60Hz frames.
+static const float graph_height = 48.0f;
+static const float graph_milliseconds = 33.3f;
+
+static const glm::vec3 pass_colors[] = {
+	glm::vec3(0.30f, 0.80f, 0.30f),
+	glm::vec3(0.30f, 0.55f, 1.00f),
+	glm::vec3(1.00f, 0.80f, 0.20f),
+	glm::vec3(1.00f, 0.35f, 0.35f),
+	glm::vec3(0.80f, 0.40f, 1.00f),
+	glm::vec3(0.30f, 0.90f, 0.90f)
+};
+
+static const std::uint32_t pass_color_count = sizeof(pass_colors) / sizeof(pass_colors[0]);
+
+FrameProfiler::FrameProfiler(const std::vector<std::string>& pass_names, std::uint32_t history_length) : pass_names(pass_names), pass_count(static_cast<std::uint32_t>(pass_names.size())),
+																										current_slot(0), has_gpu_timer(false), dropped_frames(0), frame_start_counter(0),
+																										history_length(history_length), cpu_history_head(0), gpu_history_head(0) {
+
+	queries.resize(frame_latency * (pass_count + 1) * 2, 0);
+	pass_issued.resize(frame_latency * (pass_count + 1), false);
+
+	for(std::uint32_t slot = 0; slot < frame_latency; slot++) {
+		slot_pending[slot] = false;
+	}
+
+	pass_start_counters.resize(pass_count, 0);
+	frame_cpu_times.resize(pass_count + 1, 0.0);
+	cpu_times.resize(pass_count + 1, 0.0);
+	gpu_times.resize(pass_count + 1, 0.0);
+
+	cpu_history.resize(history_length * (pass_count + 1), 0.0f);
+	gpu_history.resize(history_length * (pass_count + 1), 0.0f);
+
+	// Some drivers report timestamps as unsupported with zero counter bits.
+	GLint counter_bits = 0;
+	glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &counter_bits);
+
+	has_gpu_timer = (counter_bits != 0);
+
+	if(has_gpu_timer) {
+		glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(queries.size()), queries.data());
+	} else {
+		std::cout << "FrameProfiler: GL_TIMESTAMP queries unsupported, only CPU times are available.\n";
+	}
+
+	std::uint8_t white_pixel[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+	white_texture.SetFilterMinMax(GL_NEAREST, GL_NEAREST);
+	white_texture.Generate(1, 1, white_pixel);
+}
+
+FrameProfiler::~FrameProfiler() {
+
+	if(has_gpu_timer) {
+		glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+	}
+
+	white_texture.Delete();
+}
+
+void FrameProfiler::BeginFrame() {
+
+	// Still not back after frame_latency frames, give up on it rather than wait.
+	if(slot_pending[current_slot] && ResolveSlot(current_slot) == false) {
+		slot_pending[current_slot] = false;
+		dropped_frames++;
+	}
+
+	for(std::uint32_t pass = 0; pass <= pass_count; pass++) {
+		pass_issued[(current_slot * (pass_count + 1)) + pass] = false;
+		frame_cpu_times[pass] = 0.0;
+	}
+
+	frame_start_counter = SDL_GetPerformanceCounter();
+
+	if(has_gpu_timer) {
+		glQueryCounter(GetQuery(current_slot, pass_count, false), GL_TIMESTAMP);
+	}
+}
+
+void FrameProfiler::EndFrame() {
+
+	std::uint64_t frequency = SDL_GetPerformanceFrequency();
+
+	frame_cpu_times[pass_count] = (SDL_GetPerformanceCounter() - frame_start_counter) * 1000.0 / static_cast<double>(frequency);
+
+	for(std::uint32_t pass = 0; pass <= pass_count; pass++) {
+		cpu_times[pass] = frame_cpu_times[pass];
+		cpu_history[(cpu_history_head * (pass_count + 1)) + pass] = static_cast<float>(frame_cpu_times[pass]);
+	}
+
+	cpu_history_head = (cpu_history_head + 1) % history_length;
+
+	if(has_gpu_timer) {
+		glQueryCounter(GetQuery(current_slot, pass_count, true), GL_TIMESTAMP);
+		pass_issued[(current_slot * (pass_count + 1)) + pass_count] = true;
+		slot_pending[current_slot] = true;
+	}
+
+	current_slot = (current_slot + 1) % frame_latency;
+
+	// Read back whatever finished, oldest first so the history stays in order.
+	for(std::uint32_t i = 0; i < frame_latency; i++) {
+
+		std::uint32_t slot = (current_slot + i) % frame_latency;
+
+		if(slot_pending[slot] && ResolveSlot(slot) == false) {
+			break;
+		}
+	}
+}
+
+void FrameProfiler::BeginPass(std::uint32_t pass) {
+
+	pass_start_counters[pass] = SDL_GetPerformanceCounter();
+
+	if(has_gpu_timer) {
+		glQueryCounter(GetQuery(current_slot, pass, false), GL_TIMESTAMP);
+	}
+}
+
+void FrameProfiler::EndPass(std::uint32_t pass) {
+
+	frame_cpu_times[pass] = (SDL_GetPerformanceCounter() - pass_start_counters[pass]) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+
+	if(has_gpu_timer) {
+		glQueryCounter(GetQuery(current_slot, pass, true), GL_TIMESTAMP);
+		pass_issued[(current_slot * (pass_count + 1)) + pass] = true;
+	}
+}
+
+bool FrameProfiler::ResolveSlot(std::uint32_t slot) {
+
+	// Timestamps complete in order, once the last one is available so is the rest.
+	GLuint available = GL_FALSE;
+	glGetQueryObjectuiv(GetQuery(slot, pass_count, true), GL_QUERY_RESULT_AVAILABLE, &available);
+
+	if(available == GL_FALSE) {
+		return false;
+	}
+
+	for(std::uint32_t pass = 0; pass <= pass_count; pass++) {
+
+		double milliseconds = 0.0;
+
+		if(pass_issued[(slot * (pass_count + 1)) + pass]) {
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(GetQuery(slot, pass, false), GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(GetQuery(slot, pass, true), GL_QUERY_RESULT, &end);
+
+			milliseconds = (end > begin) ? (end - begin) / 1000000.0 : 0.0;
+		}
+
+		gpu_times[pass] = milliseconds;
+		gpu_history[(gpu_history_head * (pass_count + 1)) + pass] = static_cast<float>(milliseconds);
+	}
+
+	gpu_history_head = (gpu_history_head + 1) % history_length;
+	slot_pending[slot] = false;
+
+	return true;
+}
+
+void FrameProfiler::DrawOverlay(SpriteRenderer* sprite_renderer, TextRenderer* text_renderer, SDFFont& font, glm::vec2 position, std::int32_t sort_layer) {
+
+	const float text_size = 12.0f;
+	const float line_height = 14.0f;
+
+	char line[128];
+
+	std::snprintf(line, sizeof(line), "frame   cpu %6.2f ms   gpu %6.2f ms", GetCPUFrameTime(), GetGPUFrameTime());
+	text_renderer->DrawString(font, line, position.x, position.y, text_size, glm::vec3(1.0f), sort_layer);
+
+	for(std::uint32_t pass = 0; pass < pass_count; pass++) {
+		std::snprintf(line, sizeof(line), "%-7s cpu %6.2f ms   gpu %6.2f ms", pass_names[pass].c_str(), cpu_times[pass], gpu_times[pass]);
+		text_renderer->DrawString(font, line, position.x, position.y + ((pass + 1) * line_height), text_size, pass_colors[pass % pass_color_count], sort_layer);
+	}
+
+	float graph_y = position.y + ((pass_count + 1) * line_height) + 4.0f;
+
+	text_renderer->DrawString(font, "cpu", position.x, graph_y, text_size, glm::vec3(1.0f), sort_layer);
+	DrawGraph(sprite_renderer, cpu_history, cpu_history_head, glm::vec2(position.x + 28.0f, graph_y), sort_layer);
+
+	if(has_gpu_timer) {
+		graph_y += graph_height + 4.0f;
+
+		text_renderer->DrawString(font, "gpu", position.x, graph_y, text_size, glm::vec3(1.0f), sort_layer);
+		DrawGraph(sprite_renderer, gpu_history, gpu_history_head, glm::vec2(position.x + 28.0f, graph_y), sort_layer);
+	}
+}
+
+void FrameProfiler::DrawGraph(SpriteRenderer* sprite_renderer, const std::vector<float>& history, std::uint32_t head, glm::vec2 position, std::int32_t sort_layer) {
+
+	const float pixels_per_millisecond = graph_height / graph_milliseconds;
+
+	// Background and a line at 16.7ms.
+	sprite_renderer->DrawSprite(white_texture, position, glm::vec2(static_cast<float>(history_length), graph_height), 0.0f, glm::vec3(0.1f), sort_layer);
+	sprite_renderer->DrawSprite(white_texture, glm::vec2(position.x, position.y + graph_height - (16.7f * pixels_per_millisecond)), glm::vec2(static_cast<float>(history_length), 1.0f), 0.0f, glm::vec3(0.4f), sort_layer + 1);
+
+	// Oldest frame on the left, one column per frame with the passes stacked from the bottom.
+	for(std::uint32_t column = 0; column < history_length; column++) {
+
+		const float* times = &history[((head + column) % history_length) * (pass_count + 1)];
+		float stacked = 0.0f;
+
+		for(std::uint32_t pass = 0; pass < pass_count && stacked < graph_height; pass++) {
+
+			float height = std::min(times[pass] * pixels_per_millisecond, graph_height - stacked);
+
+			if(height <= 0.0f) {
+				continue;
+			}
+
+			stacked += height;
+
+			sprite_renderer->DrawSprite(white_texture, glm::vec2(position.x + column, position.y + graph_height - stacked), glm::vec2(1.0f, height), 0.0f, pass_colors[pass % pass_color_count], sort_layer + 1);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FRAME_PROFILER_HPP__
+#define __FRAME_PROFILER_HPP__
+
+// STL
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+#include "SDFFont.hpp"
+#include "SpriteRenderer.hpp"
+#include "TextRenderer.hpp"
+#include "Texture2D.hpp"
+
+/**
+ * CPU and GPU time per frame and per named pass.
+ *
+ * CPU time comes from SDL's performance counter. GPU time comes from glQueryCounter
+ * timestamps around each pass and around the whole frame. Timestamps rather than
+ * GL_TIME_ELAPSED queries, so passes may nest or overlap. The queries of one frame are
+ * a slot in a pool of frame_latency slots. A slot is read back a few frames later, once
+ * GL_QUERY_RESULT_AVAILABLE says so, and a slot still pending when its turn comes round
+ * again is dropped, so reading results never stalls the pipeline.
+ *
+ * Each pass is timed once per frame, passes that don't run in a frame count as zero.
+ */
+class FrameProfiler {
+
+	public:
+		FrameProfiler(const std::vector<std::string>& pass_names, std::uint32_t history_length = 240);
+		~FrameProfiler();
+
+		void BeginFrame();
+		void EndFrame();
+
+		void BeginPass(std::uint32_t pass);
+		void EndPass(std::uint32_t pass);
+
+		// Per pass timings and rolling stacked graphs of CPU and GPU time, top left at position.
+		void DrawOverlay(SpriteRenderer* sprite_renderer, TextRenderer* text_renderer, SDFFont& font, glm::vec2 position, std::int32_t sort_layer = 2);
+
+		// Milliseconds, GPU times lag a few frames behind.
+		double GetCPUPassTime(std::uint32_t pass)  { return cpu_times[pass]; }
+		double GetGPUPassTime(std::uint32_t pass)  { return gpu_times[pass]; }
+		double GetCPUFrameTime()                   { return cpu_times[pass_count]; }
+		double GetGPUFrameTime()                   { return gpu_times[pass_count]; }
+		bool   HasGPUTimer()                       { return has_gpu_timer; }
+		std::uint64_t GetDroppedFrames()           { return dropped_frames; }
+
+	private:
+		static const std::uint32_t frame_latency = 4;
+
+		std::vector<std::string> pass_names;
+		std::uint32_t pass_count;
+
+		// Two timestamps per pass plus two for the whole frame, per slot.
+		std::vector<std::uint32_t> queries;
+		std::vector<bool> pass_issued;
+		bool slot_pending[frame_latency];
+		std::uint32_t current_slot;
+
+		bool has_gpu_timer;
+		std::uint64_t dropped_frames;
+
+		std::uint64_t frame_start_counter;
+		std::vector<std::uint64_t> pass_start_counters;
+		std::vector<double> frame_cpu_times;
+
+		// Latest times, one per pass and the whole frame last.
+		std::vector<double> cpu_times;
+		std::vector<double> gpu_times;
+
+		// Rolling history, history_length rows of pass_count + 1 times.
+		std::uint32_t history_length;
+		std::vector<float> cpu_history;
+		std::vector<float> gpu_history;
+		std::uint32_t cpu_history_head;
+		std::uint32_t gpu_history_head;
+
+		Texture2D white_texture;
+
+		std::uint32_t GetQuery(std::uint32_t slot, std::uint32_t pass, bool end) { return queries[(((slot * (pass_count + 1)) + pass) * 2) + (end ? 1 : 0)]; }
+		bool ResolveSlot(std::uint32_t slot);
+		void DrawGraph(SpriteRenderer* sprite_renderer, const std::vector<float>& history, std::uint32_t head, glm::vec2 position, std::int32_t sort_layer);
+};
+
+#endif /* __FRAME_PROFILER_HPP__ */
\ No newline at end of file
@@ -15,8 +15,15 @@
  * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <set>
+#include <string>
 #include <vector>
 
 // GLAD2
@@ -38,18 +45,31 @@
 #include <nlohmann/json.hpp>
 
 #include "ArrayRenderer.hpp"
+#include "Camera.hpp"
 #include "Font.hpp"
+#include "FrameConstants.hpp"
+#include "FrameProfiler.hpp"
 #include "GameApplication.hpp"
 #include "GameMap.hpp"
 #include "GameMapLayer.hpp"
 #include "GameMapTile.hpp"
 #include "GameWorld.hpp"
+#include "HeadlessContext.hpp"
 #include "InputManager.hpp"
 #include "OverworldPlayer.hpp"
+#include "RenderQueue.hpp"
+#include "RenderState.hpp"
 #include "ResourceLoader.hpp"
+#include "SDFFont.hpp"
 #include "Shader.hpp"
 #include "SpriteRenderer.hpp"
+#include "StreamBuffer.hpp"
+#include "TextRenderer.hpp"
 #include "Texture2D.hpp"
+#include "TextureAtlas.hpp"
+#include "TileLayerRenderer.hpp"
+#include "TileMapRenderer.hpp"
+#include "WorldTileRenderer.hpp"
 
 void gl_message_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, GLchar const* message, void const* user_param) {
 
@@ -95,6 +115,8 @@ int GameApplication::Main(int argc, char** argv) {
     stored_argc = argc;
     stored_argv = argv;
 
+    ParseArguments();
+
     Initialize();
     Loop();
     Shutdown();
@@ -102,6 +124,31 @@ int GameApplication::Main(int argc, char** argv) {
     return 0;
 }
 
+void GameApplication::ParseArguments() {
+
+    for(int i = 1; i < stored_argc; i++) {
+
+        std::string argument = stored_argv[i];
+
+        if(argument == "--headless") {
+            is_headless = true;
+        } else if(argument == "--frames" && (i + 1) < stored_argc) {
+            frame_limit = std::strtoull(stored_argv[++i], nullptr, 10);
+        } else if(argument == "--checksum") {
+            print_frame_checksums = true;
+        } else if(argument == "--dump-frames" && (i + 1) < stored_argc) {
+            frame_dump_prefix = stored_argv[++i];
+        } else {
+            std::cout << "Unknown argument \"" << argument << "\". Usage: mattRPG [--headless [--checksum] [--dump-frames <prefix>]] [--frames <count>]\n";
+        }
+    }
+
+    // An automated run has to end by itself.
+    if(is_headless && frame_limit == 0) {
+        frame_limit = 60;
+    }
+}
+
 void GameApplication::Initialize() {
 
     SDL_version sdl_compiled_version, sdl_linked_version;
@@ -111,7 +158,10 @@ void GameApplication::Initialize() {
     std::cout << "Compiled with SDL2 version:       " << static_cast<int>(sdl_compiled_version.major) << "." << static_cast<int>(sdl_compiled_version.minor) << "." << static_cast<int>(sdl_compiled_version.patch) << '\n';
     std::cout << "Linked with SDL2 version:         " << static_cast<int>(sdl_linked_version.major) << "." << static_cast<int>(sdl_linked_version.minor) << "." << static_cast<int>(sdl_linked_version.patch) << '\n';
 
-	if(SDL_Init(SDL_INIT_EVERYTHING) != 0) {
+    // Without a display the video and audio subsystems would fail to start.
+    Uint32 sdl_subsystems = is_headless ? (SDL_INIT_TIMER | SDL_INIT_EVENTS) : SDL_INIT_EVERYTHING;
+
+	if(SDL_Init(sdl_subsystems) != 0) {
         std::cout << "Failed to initialize SDL. SDL_GetError(): " << SDL_GetError() << '\n';
         exit(-1);
     }
@@ -164,35 +214,59 @@ void GameApplication::Initialize() {
         exit(-1);
     }
 
-    sdl_window = SDL_CreateWindow("mattRPG", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, window_width, window_height, SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI);
+    if(is_headless) {
 
-    if(sdl_window == NULL) {
-        std::cout << "Failed to create SDL window. SDL_GetError(): " << SDL_GetError() << '\n';
-        exit(-1);
-    }
+        sdl_window = NULL;
+        sdl_gl_context = NULL;
 
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
-    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+        if(headless_context.Create(window_width, window_height) == false) {
+            std::cout << "Failed to create headless OpenGL context.\n";
+            exit(-1);
+        }
+    } else {
 
-    sdl_gl_context = SDL_GL_CreateContext(sdl_window);
+        // Context and pixel format attributes only apply to windows created after them.
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+        SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
 
-    if(sdl_gl_context == NULL) {
-        std::cout << "Failed to create SDL OpenGL context. SDL_GetError(): " << SDL_GetError() << '\n';
-        exit(-1);
-    }
+        sdl_window = SDL_CreateWindow("mattRPG", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, window_width, window_height, SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI);
 
-    if(SDL_GL_SetSwapInterval(1) != 0) {
-        std::cout << "Failed to set vertical sync. SDL_GetError(): " << SDL_GetError() << '\n';
-        exit(-1);
-    }
+        if(sdl_window == NULL) {
+            std::cout << "Failed to create SDL window. SDL_GetError(): " << SDL_GetError() << '\n';
+            exit(-1);
+        }
+
+        sdl_gl_context = SDL_GL_CreateContext(sdl_window);
+
+        if(sdl_gl_context == NULL) {
+            std::cout << "Failed to create SDL OpenGL context. SDL_GetError(): " << SDL_GetError() << '\n';
+            exit(-1);
+        }
+
+        // Layer depths are spaced finer than a 16 bit buffer resolves, draw in painter's order without a full 24 bits.
+        int depth_size = 0;
+        SDL_GL_GetAttribute(SDL_GL_DEPTH_SIZE, &depth_size);
+
+        if(depth_size < 24) {
+            std::cout << "Got a " << depth_size << " bit depth buffer instead of 24 bits, drawing in painter's order.\n";
+            has_depth_buffer = false;
+            use_depth_passes = false;
+        }
+
+        if(SDL_GL_SetSwapInterval(1) != 0) {
+            std::cout << "Failed to set vertical sync. SDL_GetError(): " << SDL_GetError() << '\n';
+            exit(-1);
+        }
 
-    int glad_version = gladLoadGL((GLADloadfunc) SDL_GL_GetProcAddress);
+        int glad_version = gladLoadGL((GLADloadfunc) SDL_GL_GetProcAddress);
 
-    std::cout << "Loaded OpenGL " << GLAD_VERSION_MAJOR(glad_version) << "." << GLAD_VERSION_MINOR(glad_version) << " using GLAD2.\n";
+        std::cout << "Loaded OpenGL " << GLAD_VERSION_MAJOR(glad_version) << "." << GLAD_VERSION_MINOR(glad_version) << " using GLAD2.\n";
 
-    // Disable VSync
-    SDL_GL_SetSwapInterval(0);
+        // Disable VSync
+        SDL_GL_SetSwapInterval(0);
+    }
 
     // Enable KHR_debug
     glEnable(GL_DEBUG_OUTPUT);
@@ -200,9 +274,12 @@ void GameApplication::Initialize() {
     glDebugMessageCallback(gl_message_callback, nullptr); // gl_message_callback defined above
     glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE); // Disable NOTIFICATION level debug messages.
 
+    // Fresh context, nothing is shadowed yet.
+    RenderState::Invalidate();
+
     // Enable alpha blending.
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    RenderState::SetCapability(GL_BLEND, true);
+    RenderState::SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     SDL_AudioSpec want, have;
 
@@ -213,9 +290,9 @@ void GameApplication::Initialize() {
     want.samples = 2048;
     want.callback = NULL;
 
-    sdl_audio_device_id = SDL_OpenAudioDevice(NULL, 0, &want, &have, SDL_AUDIO_ALLOW_ANY_CHANGE);
+    sdl_audio_device_id = is_headless ? 0 : SDL_OpenAudioDevice(NULL, 0, &want, &have, SDL_AUDIO_ALLOW_ANY_CHANGE);
 
-    if(sdl_audio_device_id == 0) {
+    if(sdl_audio_device_id == 0 && is_headless == false) {
         std::cout << "Failed to open any audio device. SDL_GetError(): " << SDL_GetError() << '\n';
         exit(-1);
     }
@@ -243,26 +320,22 @@ sdl_game_controller = SDL_GameControllerOpen(i);
 
 void GameApplication::Loop() {
 
-    glm::mat4 projection_matrix = glm::ortho(0.0f, static_cast<float>(window_width), static_cast<float>(window_height), 0.0f, -1.0f, 1.0f);
-
     // Font
     ResourceLoader::LoadFont("./resource/Fonts/Kenney Future Square.ttf", 32, "kenney_future_square");
     ResourceLoader::LoadFont("./resource/Fonts/Alagard.ttf", 32, "alagard");
     ResourceLoader::LoadFont("./resource/Fonts/Romulus.ttf", 32, "romulus");
-
-    // Shaders
-    ResourceLoader::LoadShader("./resource/Shaders/sprite.vert.glsl", "./resource/Shaders/sprite.frag.glsl", nullptr, "sprite");
-    ResourceLoader::GetShader("sprite").Use();
-    ResourceLoader::GetShader("sprite").SetInteger("image", 0);
-    ResourceLoader::GetShader("sprite").SetVector2f("TexCoordShift", 0.0f, 0.0f);
-    ResourceLoader::GetShader("sprite").SetMatrix4f("projection", projection_matrix);
-
-    ResourceLoader::LoadShader("./resource/Shaders/array.vert.glsl", "./resource/Shaders/array.frag.glsl", nullptr, "array");
-    ResourceLoader::GetShader("array").Use();
-    ResourceLoader::GetShader("array").SetInteger("texarray", 0);
-    ResourceLoader::GetShader("array").SetIntegerUnsigned("diffuse_layer", 0);
-    ResourceLoader::GetShader("array").SetVector2f("TexCoordShift", 0.0f, 0.0f);
-    ResourceLoader::GetShader("array").SetMatrix4f("projection", projection_matrix);
+    ResourceLoader::LoadSDFFont("./resource/Fonts/Kenney Future Square.ttf", "kenney_future_square_sdf");
+
+    // Shaders, compiled by the driver in the background while everything else loads.
+    ResourceLoader::LoadShaderAsync("./resource/Shaders/sprite.vert.glsl", "./resource/Shaders/sprite.frag.glsl", nullptr, "sprite");
+    ResourceLoader::LoadShaderAsync("./resource/Shaders/sprite_batch.vert.glsl", "./resource/Shaders/sprite_batch.frag.glsl", nullptr, "sprite_batch");
+    ResourceLoader::LoadShaderAsync("./resource/Shaders/sprite_batch.vert.glsl", "./resource/Shaders/sdf_text.frag.glsl", nullptr, "sdf_text");
+    ResourceLoader::LoadShaderAsync("./resource/Shaders/array.vert.glsl", "./resource/Shaders/array.frag.glsl", nullptr, "array");
+    ResourceLoader::LoadShaderAsync("./resource/Shaders/tile_layer.vert.glsl", "./resource/Shaders/tile_layer.frag.glsl", nullptr, "tile_layer");
+    ResourceLoader::LoadShaderAsync("./resource/Shaders/tile_map.vert.glsl", "./resource/Shaders/tile_map.frag.glsl", nullptr, "tile_map");
+    ResourceLoader::LoadShaderAsync("./resource/Shaders/world_tiles.vert.glsl", "./resource/Shaders/tile_layer.frag.glsl", nullptr, "world_tiles");
+    ResourceLoader::LoadShaderAsync("./resource/Shaders/tile_map.vert.glsl", "./resource/Shaders/tile_map.frag.glsl", nullptr, "tile_map", SHADER_VARIANT_ALPHA_TEST);
+    ResourceLoader::LoadShaderAsync("./resource/Shaders/tile_map.vert.glsl", "./resource/Shaders/tile_map.frag.glsl", nullptr, "tile_map", SHADER_VARIANT_TRANSLUCENT_ONLY);
 
     // UI Elements
     //ResourceLoader::LoadTexture("./resource/external/moderna-graphical-interface/toolbar.png", true, "ui_toolbar");
@@ -275,17 +348,16 @@ void GameApplication::Loop() {
         "player_idle4"
     };
 
-    ResourceLoader::LoadTexture("./resource/CreaturePack/Rampart/Hunter/HunterIdle(Frame 1).png", true, true, player_idles[0]);
-    ResourceLoader::LoadTexture("./resource/CreaturePack/Rampart/Hunter/HunterIdle(Frame 2).png", true, true, player_idles[1]);
-    ResourceLoader::LoadTexture("./resource/CreaturePack/Rampart/Hunter/HunterIdle(Frame 3).png", true, true, player_idles[2]);
-    ResourceLoader::LoadTexture("./resource/CreaturePack/Rampart/Hunter/HunterIdle(Frame 4).png", true, true, player_idles[3]);
+    // Animation frames share one atlas, switching frames doesn't switch textures.
+    ResourceLoader::LoadTextureAtlas({
+        { player_idles[0], "./resource/CreaturePack/Rampart/Hunter/HunterIdle(Frame 1).png" },
+        { player_idles[1], "./resource/CreaturePack/Rampart/Hunter/HunterIdle(Frame 2).png" },
+        { player_idles[2], "./resource/CreaturePack/Rampart/Hunter/HunterIdle(Frame 3).png" },
+        { player_idles[3], "./resource/CreaturePack/Rampart/Hunter/HunterIdle(Frame 4).png" }
+    }, true, "creatures");
 
     ResourceLoader::LoadGameWorld("./resource/test.ldtk", "world");
 
-    // Renderers
-    ArrayRenderer* array_renderer = new ArrayRenderer(ResourceLoader::GetShader("array"));
-    SpriteRenderer* sprite_renderer = new SpriteRenderer(ResourceLoader::GetShader("sprite"));
-
     std::ifstream input_file("./resource/test.ldtk");
 
     nlohmann::json input_json;
@@ -297,17 +369,80 @@ void GameApplication::Loop() {
 
         for(auto tileset : input_json.find<std::string>("defs").value().find<std::string>("tilesets").value()) {
             std::string file_name = tileset.find("relPath").value();
-            ResourceLoader::LoadTextureArray(std::string("./resource/" + file_name).c_str(), true, true, tileset["identifier"], 16, 16);
+            ResourceLoader::LoadTextureArrayAsync(std::string("./resource/" + file_name).c_str(), true, true, tileset["identifier"], 16, 16);
+        }
+    }
+
+    // Headless frames get compared between runs, which frames without renderers or with placeholder textures would make racy.
+    while(is_headless && ResourceLoader::PollShaders() == false) {
+        SDL_Delay(1);
+    }
+
+    while(is_headless && ResourceLoader::PollTextures() == false) {
+        SDL_Delay(1);
+    }
+
+    // Streaming vertex data, one 4 MiB region per frame in flight.
+    StreamBuffer* stream_buffer = new StreamBuffer(4 * 1024 * 1024);
+
+    // Renderers resolve their uniforms on creation, they are created in the frame loop once every program has linked.
+    ArrayRenderer* array_renderer = nullptr;
+    SpriteRenderer* sprite_renderer = nullptr;
+    TileLayerRenderer* tile_layer_renderer = nullptr;
+    TileMapRenderer* tile_map_renderer = nullptr;
+    SpriteRenderer* sdf_text_renderer = nullptr;
+    TextRenderer* text_renderer = nullptr;
+    WorldTileRenderer* world_tile_renderer = nullptr;
+    RenderQueue* render_queue = nullptr;
+
+    // Projection, view, viewport and time for every shader, one uniform buffer upload per frame.
+    FrameConstants* frame_constants = new FrameConstants();
+
+    // Profiled passes, indices into the FrameProfiler pass names.
+    const std::uint32_t profile_pass_tiles = 0;
+    const std::uint32_t profile_pass_sprites = 1;
+    const std::uint32_t profile_pass_text = 2;
+    const std::uint32_t profile_pass_swap = 3;
+
+    FrameProfiler* frame_profiler = new FrameProfiler({ "tiles", "sprites", "text", "swap" });
+
+    // RenderQueue layers, drawn in increasing order.
+    const std::uint8_t render_layer_world = 0;
+    const std::uint8_t render_layer_entities = 1;
+
+    camera.SetViewport(static_cast<float>(window_width), static_cast<float>(window_height));
+    camera.SetPosition(glm::vec2(0.5f * window_width, 0.5f * window_height));
+
+    Font font_alagard = ResourceLoader::GetFont("alagard");
+    Font font_kenney_future_square = ResourceLoader::GetFont("kenney_future_square");
+    Font font_romulus = ResourceLoader::GetFont("romulus");
+    SDFFont font_kenney_future_square_sdf = ResourceLoader::GetSDFFont("kenney_future_square_sdf");
+
+    TextureAtlas creature_atlas = ResourceLoader::GetTextureAtlas("creatures");
+
+    // Tilesets the world's layers refer to, handed to the WorldTileRenderer every frame as they stream in.
+    std::set<std::string> world_tileset_names;
+
+    for(auto& map : ResourceLoader::GetGameWorld("world").GetMaps()) {
+        for(auto& layer : map.GetLayers()) {
+            if(layer.GetLayerType() == GameMapLayerType::Tiles) {
+                world_tileset_names.insert(layer.GetTileSetName());
+            }
         }
     }
 
     int idle_loop = 0;
 
+    bool is_occlusion_built = false;
+
     while(is_running) {
 
         frame_start = SDL_GetPerformanceCounter();
         ticks_start = SDL_GetTicks();
 
+        RenderState::BeginFrame();
+        frame_profiler->BeginFrame();
+
         while(SDL_PollEvent(&sdl_event)) {
         
             switch(sdl_event.type) {
@@ -361,27 +496,150 @@ void GameApplication::Loop() {
             }            
         }
 
+        stream_buffer->BeginFrame();
+
+        // Tilesets stream in over the first frames, layers draw with a placeholder until theirs is resident.
+        bool textures_ready = ResourceLoader::PollTextures();
+
+        // Tile opacity is only known once every tileset is in.
+        if(textures_ready && is_occlusion_built == false) {
+            UpdateOcclusion();
+            is_occlusion_built = true;
+        }
+
+        // Programs link in the background over the first frames, set up their defaults and the renderers once all are in.
+        if(render_queue == nullptr && ResourceLoader::PollShaders()) {
+            std::cout << "GameApplication: " << ResourceLoader::GetShaderCacheHits() << " shaders loaded from cache, " << ResourceLoader::GetShaderCacheMisses() << " compiled, "
+                      << ResourceLoader::GetShaderLoadTime() << "ms in total.\n";
+
+            ResourceLoader::GetShader("sprite").Use();
+            ResourceLoader::GetShader("sprite").SetInteger("image", 0);
+            ResourceLoader::GetShader("sprite").SetVector2f("TexCoordShift", 0.0f, 0.0f);
+
+            ResourceLoader::GetShader("sprite_batch").Use();
+            ResourceLoader::GetShader("sprite_batch").SetInteger("image", 0);
+
+            ResourceLoader::GetShader("sdf_text").Use();
+            ResourceLoader::GetShader("sdf_text").SetInteger("image", 0);
+
+            ResourceLoader::GetShader("array").Use();
+            ResourceLoader::GetShader("array").SetInteger("texarray", 0);
+            ResourceLoader::GetShader("array").SetIntegerUnsigned("diffuse_layer", 0);
+            ResourceLoader::GetShader("array").SetVector2f("TexCoordShift", 0.0f, 0.0f);
+
+            ResourceLoader::GetShader("tile_layer").Use();
+            ResourceLoader::GetShader("tile_layer").SetInteger("texarray", 0);
+
+            ResourceLoader::GetShader("tile_map").Use();
+            ResourceLoader::GetShader("tile_map").SetInteger("texarray", 0);
+            ResourceLoader::GetShader("tile_map").SetInteger("tilemap", 1);
+
+            array_renderer = new ArrayRenderer(ResourceLoader::GetShader("array"));
+            sprite_renderer = new SpriteRenderer(ResourceLoader::GetShader("sprite"), ResourceLoader::GetShader("sprite_batch"));
+            sprite_renderer->SetBatching(true);
+            sprite_renderer->SetStreamBuffer(stream_buffer);
+            tile_layer_renderer = new TileLayerRenderer(ResourceLoader::GetShader("tile_layer"));
+            tile_map_renderer = new TileMapRenderer(ResourceLoader::GetShader("tile_map"), ResourceLoader::GetShader("tile_map", SHADER_VARIANT_ALPHA_TEST), ResourceLoader::GetShader("tile_map", SHADER_VARIANT_TRANSLUCENT_ONLY));
+            sdf_text_renderer = new SpriteRenderer(ResourceLoader::GetShader("sprite"), ResourceLoader::GetShader("sdf_text"));
+            sdf_text_renderer->SetBatching(true);
+            sdf_text_renderer->SetStreamBuffer(stream_buffer);
+            text_renderer = new TextRenderer(sprite_renderer, sdf_text_renderer);
+            world_tile_renderer = new WorldTileRenderer(ResourceLoader::GetShader("world_tiles"));
+            render_queue = new RenderQueue(array_renderer, sprite_renderer, tile_layer_renderer, tile_map_renderer, world_tile_renderer);
+
+            // sprite.* and array.* aren't in the tree, those still declaring a "projection" uniform get it set on every Bind().
+            const char* frame_shader_names[] = { "sprite", "sprite_batch", "sdf_text", "array", "tile_layer", "tile_map", "world_tiles" };
+
+            for(auto shader_name : frame_shader_names) {
+                frame_constants->AddFallbackShader(ResourceLoader::GetShader(shader_name));
+            }
+        }
+
+        // The depth mask is left on by the render queue, the clear needs it.
+        RenderState::SetDepthMask(true);
+
         glClearColor(0, 0, 0, 1);
-        glClear(GL_COLOR_BUFFER_BIT);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Nothing draws until the programs are in, keep presenting cleared frames meanwhile.
+        if(render_queue == nullptr) {
+            stream_buffer->EndFrame();
+            PresentFrame();
+            frame_profiler->EndFrame();
+            frame_count++;
+            SDL_Delay(1);
+            continue;
+        }
+
+        render_queue->SetDepthPasses(use_depth_passes);
 
         // Tileset test
         //for(auto i = 0; i < ResourceLoader::GetTexture("GrassBiome").GetSubImageCount(); i++) {
         //    array_renderer->DrawArray(ResourceLoader::GetTexture("GrassBiome"), i, glm::vec2(((i % 16) * 16), ((i / 16) * 16)));
         //}
 
+        frame_profiler->BeginPass(profile_pass_tiles);
+
+        // Headless frames step time at a fixed rate so they stay comparable between runs.
+        float frame_seconds = is_headless ? (frame_count / 60.0f) : (ticks_start / 1000.0f);
+
+        frame_constants->Update(camera.GetProjection(), camera.GetView(), camera.GetViewport(), frame_seconds);
+
+        // World draws are submitted in any order, sorted and drawn on Flush through the camera.
+        frame_constants->Bind(FrameSpace::World);
+
+        // Every level and layer in a few multi-draws, only rebuilt when the camera enters other chunks.
+        if(tile_render_mode == TileRenderMode::World) {
+            for(auto& tileset_name : world_tileset_names) {
+                Texture2D tileset = ResourceLoader::GetTexture(tileset_name);
+                world_tile_renderer->SetTileSet(tileset_name, tileset);
+            }
+
+            world_tile_renderer->Update(ResourceLoader::GetGameWorld("world"), camera);
+            render_queue->SubmitWorld(render_layer_world, 0);
+        }
+
         // Gameworld test
         //for(auto map : ResourceLoader::GetGameWorld("world").GetMaps()) {
         auto tile_size = ResourceLoader::GetGameWorld("world").GetTileSize();
-        auto map = ResourceLoader::GetGameWorld("world").GetMaps().at(0);
+        auto& map = ResourceLoader::GetGameWorld("world").GetMaps().at(0);
             // Maybe in C++23 we'll get a reverse range based for loop.
-            for(size_t i = (map.GetLayers().size() - 1); i > 0; i--) {
-                auto layer = map.GetLayers().at(i);
+            for(size_t i = map.GetLayers().size(); i-- > 0;) {
+                // Already submitted as a whole.
+                if(tile_render_mode == TileRenderMode::World) {
+                    break;
+                }
+
+                auto& layer = map.GetLayers().at(i);
                 // Only render if it's Tiles. Entities handled elsewhere.
-                if(layer.GetLayerType() == GameMapLayerType::Tiles) {
-                    for(size_t y = 0; y < layer.GetTiles().size(); y++) {
-                        for(size_t x = 0; x < layer.GetTiles()[y].size(); x++) {
-                            if(layer.GetTiles()[y][x].GetTileSetIndex() != 0) {
-                                array_renderer->DrawArray(ResourceLoader::GetTexture(layer.GetTileSetName()), layer.GetTiles()[y][x].GetTileSetIndex(), glm::vec2(x * tile_size, y * tile_size));
+                if(layer.GetLayerType() != GameMapLayerType::Tiles) {
+                    continue;
+                }
+
+                // LDtk lists layers top first, so the last layer is the deepest.
+                std::uint16_t depth = static_cast<std::uint16_t>(map.GetLayers().size() - 1 - i);
+                Texture2D tileset = ResourceLoader::GetTexture(layer.GetTileSetName());
+
+                // Only the tiles under the camera are walked or drawn.
+                TileRange visible_tiles = camera.GetVisibleTiles(layer);
+
+                if(visible_tiles.IsEmpty()) {
+                    continue;
+                }
+
+                if(tile_render_mode == TileRenderMode::Instanced) {
+                    render_queue->SubmitTileLayer(render_layer_world, depth, layer, tileset, glm::vec2(0.0f), glm::vec3(1.0f), RenderBlendMode::Alpha, &visible_tiles);
+                } else if(tile_render_mode == TileRenderMode::TileMap) {
+                    render_queue->SubmitTileMap(render_layer_world, depth, layer, tileset, glm::vec2(0.0f), glm::vec3(1.0f), RenderBlendMode::Alpha, &visible_tiles);
+                } else {
+                    size_t y_end = std::min<size_t>(visible_tiles.y_end, layer.GetTiles().size());
+
+                    for(size_t y = visible_tiles.y_begin; y < y_end; y++) {
+                        size_t x_end = std::min<size_t>(visible_tiles.x_end, layer.GetTiles()[y].size());
+
+                        for(size_t x = visible_tiles.x_begin; x < x_end; x++) {
+                            if(layer.GetTiles()[y][x].GetTileSetIndex() != 0 && layer.IsTileHidden(x, y) == false) {
+                                render_queue->SubmitTile(render_layer_world, depth, tileset, layer.GetTiles()[y][x].GetTileSetIndex(), glm::vec2(x * tile_size, y * tile_size));
                             }
                         }
                     }
@@ -389,7 +647,22 @@ void GameApplication::Loop() {
             }
         //}
 
-        sprite_renderer->DrawSprite(ResourceLoader::GetTexture(player_idles[idle_loop]), glm::vec2((window_width / 2), (window_height / 2)), glm::vec2(16, 16));
+        // Entities sort above the world anyway, flushing the tiles first lets each be timed on its own.
+        render_queue->Flush();
+
+        frame_profiler->EndPass(profile_pass_tiles);
+        frame_profiler->BeginPass(profile_pass_sprites);
+
+        TextureRegion player_region = creature_atlas.GetRegion(player_idles[idle_loop]);
+        render_queue->SubmitSpriteRegion(render_layer_entities, 0, player_region, glm::vec2((window_width / 2), (window_height / 2)), glm::vec2(16, 16));
+
+        render_queue->Flush();
+
+        frame_profiler->EndPass(profile_pass_sprites);
+        frame_profiler->BeginPass(profile_pass_text);
+
+        // The UI below is drawn in screen space.
+        frame_constants->Bind(FrameSpace::Screen);
 
         idle_loop++;
 
@@ -397,24 +670,58 @@ void GameApplication::Loop() {
             idle_loop = 0;
         }
 
-        ResourceLoader::GetFont("alagard").Draw(sprite_renderer, std::to_string(frame_rate).c_str(), 32, 32);
-        ResourceLoader::GetFont("alagard").Draw(sprite_renderer, "The quick brown fox jumps over the lazy dog.", 32, 128);
-        ResourceLoader::GetFont("kenney_future_square").Draw(sprite_renderer, "The quick brown fox jumps over the lazy dog.", 32, 160);
-        ResourceLoader::GetFont("romulus").Draw(sprite_renderer, "The quick brown fox jumps over the lazy dog.", 32, 192);
+        // UI text goes on top of the world, on sort layer 1 to stay above anything else in the sprite batch.
+        // The frame rate differs between runs, keep it out of headless frames.
+        if(is_headless == false) {
+            text_renderer->DrawString(font_alagard, std::to_string(frame_rate).c_str(), 32, 32, glm::vec3(1.0f), 1);
+        }
 
-        SDL_GL_SwapWindow(sdl_window);
+        text_renderer->DrawString(font_alagard, ("GL calls: " + std::to_string(RenderState::GetIssuedCalls()) + " issued, " + std::to_string(RenderState::GetSkippedCalls()) + " skipped").c_str(), 32, 64, glm::vec3(1.0f), 1);
+
+        // Fence waits differ between runs, so like the frame rate they stay out of headless frames.
+        if(is_headless == false) {
+            text_renderer->DrawString(font_alagard, ("Stream: " + std::to_string(stream_buffer->GetBytesStreamed() / 1024) + " KB, " + std::to_string(static_cast<int>(stream_buffer->GetFenceWaitTime() * 1000.0)) + "us fence wait").c_str(), 32, 96, glm::vec3(1.0f), 1);
+        }
+
+        if(tile_render_mode == TileRenderMode::World) {
+            text_renderer->DrawString(font_alagard, ("World: " + std::to_string(world_tile_renderer->GetVisibleCommandCount()) + " of " + std::to_string(world_tile_renderer->GetChunkCount()) + " chunks, " + std::to_string(world_tile_renderer->GetDrawCallCount()) + " multi-draws").c_str(), 32, 128, glm::vec3(1.0f), 1);
+        }
+
+        text_renderer->DrawString(font_alagard, "The quick brown fox jumps over the lazy dog.", 32, 160, glm::vec3(1.0f), 1);
+        text_renderer->DrawString(font_kenney_future_square, "The quick brown fox jumps over the lazy dog.", 32, 192, glm::vec3(1.0f), 1);
+        text_renderer->DrawString(font_romulus, "The quick brown fox jumps over the lazy dog.", 32, 224, glm::vec3(1.0f), 1);
+
+        // Same face at several sizes from one distance field atlas.
+        text_renderer->DrawString(font_kenney_future_square_sdf, "The quick brown fox jumps over the lazy dog.", 32.0f, 272.0f, 16.0f);
+        text_renderer->DrawString(font_kenney_future_square_sdf, "The quick brown fox jumps over the lazy dog.", 32.0f, 296.0f, 32.0f);
+        text_renderer->DrawString(font_kenney_future_square_sdf, "The quick brown fox jumps over the lazy dog.", 32.0f, 336.0f, 64.0f);
+
+        // Timings are from frames already finished, on sort layer 2 above the rest of the UI.
+        if(show_profiler_overlay && is_headless == false) {
+            frame_profiler->DrawOverlay(sprite_renderer, text_renderer, font_kenney_future_square_sdf, glm::vec2(8.0f, window_height - 180.0f), 2);
+        }
+
+        sprite_renderer->Flush();
+        sdf_text_renderer->Flush();
+
+        frame_profiler->EndPass(profile_pass_text);
+
+        stream_buffer->EndFrame();
+
+        frame_profiler->BeginPass(profile_pass_swap);
+
+        PresentFrame();
+
+        frame_profiler->EndPass(profile_pass_swap);
+        frame_profiler->EndFrame();
     
         frame_end = SDL_GetPerformanceCounter();
         ticks_end = SDL_GetTicks();
 
-        // FPS Calculation using SDL timer.
-        frame_time = (ticks_end - ticks_start);
-        frame_rate = 1000.0f / frame_time;
-
-        // FPS Calculation using high precision timer (doesn't work haha).
+        // FPS Calculation using the high precision timer, milliseconds per frame.
         perf_freq = SDL_GetPerformanceFrequency();
-        //frame_time = (frame_end - frame_start) / static_cast<double>(perf_freq);
-        //frame_rate = 1 / (frame_time * 1000.0);
+        frame_time = (frame_end - frame_start) * 1000.0 / static_cast<double>(perf_freq);
+        frame_rate = 1000.0 / frame_time;
 
         frame_count++;
 
@@ -422,17 +729,105 @@ void GameApplication::Loop() {
     }
 }
 
+void GameApplication::UpdateOcclusion() {
+
+    size_t hidden_count = 0;
+
+    for(auto& map : ResourceLoader::GetGameWorld("world").GetMaps()) {
+
+        std::map<std::string, std::vector<TileOpacity>> tile_opacity;
+
+        for(auto& layer : map.GetLayers()) {
+
+            if(layer.GetLayerType() != GameMapLayerType::Tiles || tile_opacity.count(layer.GetTileSetName()) != 0) {
+                continue;
+            }
+
+            Texture2D tileset = ResourceLoader::GetTexture(layer.GetTileSetName());
+            std::vector<TileOpacity> opacity(tileset.GetSubImageCount());
+
+            for(std::uint32_t i = 0; i < tileset.GetSubImageCount(); i++) {
+                opacity[i] = tileset.GetSubImageOpacity(i);
+            }
+
+            tile_opacity[layer.GetTileSetName()] = opacity;
+        }
+
+        hidden_count += map.UpdateOcclusion(tile_opacity);
+    }
+
+    std::cout << "GameApplication: " << hidden_count << " tiles hidden under opaque tiles or empty.\n";
+}
+
+void GameApplication::PresentFrame() {
+
+    if(is_headless == false) {
+        SDL_GL_SwapWindow(sdl_window);
+    }
+
+    if(frame_limit != 0 && (frame_count + 1) >= frame_limit) {
+        RequestExit();
+    }
+
+    if(is_headless == false || (print_frame_checksums == false && frame_dump_prefix.empty())) {
+        return;
+    }
+
+    std::vector<std::uint8_t> pixels;
+    headless_context.ReadPixels(pixels);
+
+    if(print_frame_checksums) {
+        char checksum[17];
+        std::snprintf(checksum, sizeof(checksum), "%016llx", static_cast<unsigned long long>(HeadlessContext::Checksum(pixels)));
+        std::cout << "Frame " << frame_count << " checksum " << checksum << "\n";
+    }
+
+    if(frame_dump_prefix.empty() == false) {
+        headless_context.SavePNG(pixels, frame_dump_prefix + std::to_string(frame_count) + ".png");
+    }
+}
+
+void GameApplication::CycleTileRenderMode() {
+
+    switch(tile_render_mode) {
+        case TileRenderMode::PerTile:
+            tile_render_mode = TileRenderMode::Instanced;
+            std::cout << "Tile render mode: Instanced.\n";
+            break;
+        case TileRenderMode::Instanced:
+            tile_render_mode = TileRenderMode::TileMap;
+            std::cout << "Tile render mode: TileMap.\n";
+            break;
+        case TileRenderMode::TileMap:
+            tile_render_mode = TileRenderMode::World;
+            std::cout << "Tile render mode: World.\n";
+            break;
+        case TileRenderMode::World:
+        default:
+            tile_render_mode = TileRenderMode::PerTile;
+            std::cout << "Tile render mode: PerTile.\n";
+            break;
+    }
+}
+
 void GameApplication::Shutdown() {
 
     SDL_EnableScreenSaver();
 
     SDL_GameControllerClose(sdl_game_controller);
 
-    SDL_CloseAudioDevice(sdl_audio_device_id);
+    // Joins the texture streaming workers, and needs the context to delete GL objects.
+    ResourceLoader::UnloadAll();
 
-    SDL_GL_DeleteContext(sdl_gl_context);
+    if(is_headless) {
+        headless_context.Destroy();
+    } else {
+        SDL_CloseAudioDevice(sdl_audio_device_id);
 
-    SDL_DestroyWindow(sdl_window);
+        SDL_GL_DeleteContext(sdl_gl_context);
+
+        SDL_DestroyWindow(sdl_window);
+    }
 
     TTF_Quit();
 
@@ -20,11 +20,22 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
 
 #include "SDL.h"
 
+#include "Camera.hpp"
+#include "HeadlessContext.hpp"
 #include "InputManager.hpp"
 
+// Selects how Tiles layers are drawn in Loop, cycled at runtime for benchmarking.
+enum class TileRenderMode {
+	PerTile,   // One ArrayRenderer::DrawArray call per tile.
+	Instanced, // One TileLayerRenderer::DrawLayer call per layer.
+	TileMap,   // One TileMapRenderer::DrawLayer quad per layer.
+	World      // Every level at once, WorldTileRenderer multi-draws per tileset.
+};
+
 class GameApplication {
 
 	public:
@@ -34,9 +45,27 @@ class GameApplication {
 		void Loop();
 		void Shutdown();
 
+		// Swap the window, or read back and record the offscreen frame when headless.
+		void PresentFrame();
+
 		void RequestExit() { is_running = false; }
 
+		void CycleTileRenderMode();
+
+		void ToggleProfilerOverlay() { show_profiler_overlay = !show_profiler_overlay; }
+
+		void ToggleDepthPasses() { use_depth_passes = has_depth_buffer && !use_depth_passes; }
+
+		Camera& GetCamera() { return camera; }
+
+		bool IsHeadless() { return is_headless; }
+
 	private:
+		void ParseArguments();
+
+		// Hide every empty tile of the world and every tile covered by an opaque tile above it, once the tilesets are loaded.
+		void UpdateOcclusion();
+
 		SDL_Window*         sdl_window;
 		SDL_GLContext       sdl_gl_context;
 		SDL_AudioDeviceID   sdl_audio_device_id;
@@ -45,6 +74,19 @@ class GameApplication {
 
 		std::unique_ptr<InputManager> input_manager;
 
+		TileRenderMode tile_render_mode = TileRenderMode::World;
+
+		// CPU and GPU pass timings and graphs, toggled with F3. Never shown headless.
+		bool show_profiler_overlay = true;
+
+		// Opaque front to back then translucent back to front, or painter's order. Toggled with F2.
+		bool use_depth_passes = true;
+
+		// Depth passes need a 24 bit depth buffer, painter's order is all that's left without one.
+		bool has_depth_buffer = true;
+
+		Camera camera;
+
 		int window_width = 640;
 		int window_height = 480;
 
@@ -60,6 +102,17 @@ class GameApplication {
 		int stored_argc;
 		char** stored_argv;
 
+		// --headless renders through EGL into an offscreen framebuffer, with no window or audio.
+		HeadlessContext headless_context;
+		bool is_headless = false;
+
+		// Exit after this many frames, 0 runs until asked to quit.
+		std::uint64_t frame_limit = 0;
+
+		// Headless only, --checksum prints a checksum of every frame, --dump-frames saves them as PNGs.
+		bool print_frame_checksums = false;
+		std::string frame_dump_prefix;
+
 		bool is_running = false;
 };
 
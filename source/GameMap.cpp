@@ -15,4 +15,94 @@
  * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "GameMap.hpp"
\ No newline at end of file
+// STL
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "GameMap.hpp"
+#include "GameMapLayer.hpp"
+#include "GameMapTile.hpp"
+#include "TileOpacity.hpp"
+
+static TileOpacity GetTileOpacity(const std::map<std::string, std::vector<TileOpacity>>& tile_opacity, GameMapLayer& layer, int tileset_index) {
+
+	auto opacity = tile_opacity.find(layer.GetTileSetName());
+
+	if(opacity == tile_opacity.end() || tileset_index < 0 || static_cast<size_t>(tileset_index) >= opacity->second.size()) {
+		return TileOpacity::Partial;
+	}
+
+	return opacity->second[tileset_index];
+}
+
+size_t GameMap::UpdateOcclusion(const std::map<std::string, std::vector<TileOpacity>>& tile_opacity) {
+
+	std::uint16_t layer_count = static_cast<std::uint16_t>(layers.size());
+
+	topmost_opaque_layers.assign(width_tiles * height_tiles, layer_count);
+
+	// Layers are stored top first, so the first opaque tile found in a cell is the topmost one.
+	for(std::uint16_t i = 0; i < layer_count; i++) {
+
+		GameMapLayer& layer = layers[i];
+
+		if(layer.GetLayerType() != GameMapLayerType::Tiles) {
+			continue;
+		}
+
+		auto& tiles = layer.GetTiles();
+
+		for(size_t y = 0; y < tiles.size() && y < height_tiles; y++) {
+			for(size_t x = 0; x < tiles[y].size() && x < width_tiles; x++) {
+
+				std::uint16_t& topmost = topmost_opaque_layers[(y * width_tiles) + x];
+				int tileset_index = tiles[y][x].GetTileSetIndex();
+
+				if(topmost == layer_count && tileset_index != 0 && GetTileOpacity(tile_opacity, layer, tileset_index) == TileOpacity::Opaque) {
+					topmost = i;
+				}
+			}
+		}
+	}
+
+	size_t hidden_count = 0;
+
+	for(std::uint16_t i = 0; i < layer_count; i++) {
+
+		GameMapLayer& layer = layers[i];
+
+		if(layer.GetLayerType() != GameMapLayerType::Tiles) {
+			continue;
+		}
+
+		auto& tiles = layer.GetTiles();
+
+		std::vector<bool> hidden(layer.GetTileCount(), false);
+		size_t layer_hidden_count = 0;
+
+		for(size_t y = 0; y < tiles.size() && y < height_tiles; y++) {
+			for(size_t x = 0; x < tiles[y].size() && x < width_tiles; x++) {
+				int tileset_index = tiles[y][x].GetTileSetIndex();
+
+				if(tileset_index == 0) {
+					continue;
+				}
+
+				// Covered from above, or nothing to draw in the first place.
+				if(topmost_opaque_layers[(y * width_tiles) + x] < i || GetTileOpacity(tile_opacity, layer, tileset_index) == TileOpacity::Empty) {
+					hidden[(y * layer.GetWidthTiles()) + x] = true;
+					layer_hidden_count++;
+				}
+			}
+		}
+
+		// Layers only get rebuilt by the renderers if their hidden tiles actually changed.
+		layer.SetHiddenTiles(layer_hidden_count != 0 ? std::move(hidden) : std::vector<bool>());
+
+		hidden_count += layer_hidden_count;
+	}
+
+	return hidden_count;
+}
\ No newline at end of file
@@ -19,26 +19,47 @@
 #define __GAME_MAP_HPP__
 
 // STL
+#include <cstdint>
+#include <map>
+#include <string>
 #include <vector>
 
 #include "GameMapLayer.hpp"
+#include "TileOpacity.hpp"
 
 class GameMap {
 
 	public:
-		GameMap() : tile_size(16), width_tiles(0), height_tiles(0) { }
-		GameMap(int tile_size, size_t width_tiles, size_t height_tiles) : tile_size(tile_size), width_tiles(width_tiles), height_tiles(height_tiles) { }
+		GameMap() : width_tiles(0), height_tiles(0), tile_size(16), world_x(0), world_y(0) { }
+		GameMap(int tile_size, size_t width_tiles, size_t height_tiles, int world_x = 0, int world_y = 0) : width_tiles(width_tiles), height_tiles(height_tiles), tile_size(tile_size), world_x(world_x), world_y(world_y) { }
 
 		std::vector<GameMapLayer>& GetLayers() { return layers; }
 
+		// Position of the top left corner in the GameWorld, in pixels.
+		int GetWorldX() { return world_x; }
+		int GetWorldY() { return world_y; }
+
 		size_t GetLayerCount() { return layers.size(); }
 
+		// Find the topmost layer with an opaque tile in every cell and hide the tiles beneath it, along
+		// with empty tiles. tile_opacity maps a tileset name to the opacity of each tileset index, tiles
+		// missing from it count as Partial. Run again after editing tiles, returns the number of tiles hidden.
+		size_t UpdateOcclusion(const std::map<std::string, std::vector<TileOpacity>>& tile_opacity);
+
+		// Index into GetLayers(), GetLayerCount() if no layer covers the cell.
+		size_t GetTopmostOpaqueLayer(size_t x, size_t y) { return topmost_opaque_layers.empty() ? layers.size() : topmost_opaque_layers[(y * width_tiles) + x]; }
+
 	private:
 		std::vector<GameMapLayer> layers;
 
+		// Per cell, row by row, as of the last UpdateOcclusion.
+		std::vector<std::uint16_t> topmost_opaque_layers;
+
 		size_t width_tiles, height_tiles;
 
 		int tile_size;
+
+		int world_x, world_y;
 };
 
 #endif /* __GAME_MAP_HPP__ */
\ No newline at end of file
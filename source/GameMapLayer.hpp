@@ -19,7 +19,9 @@
 #define __GAME_MAP_LAYER_HPP__
 
 // STL
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "GameMapTile.hpp"
@@ -40,6 +42,12 @@ class GameMapLayer {
 
 		std::vector<std::vector<GameMapTile>>& GetTiles() { return tiles; }
 
+		// Renderers cache GPU data per layer and rebuild it when the revision changes.
+		// Call MarkChanged() after editing tiles through GetTiles() directly.
+		void SetTile(size_t x, size_t y, GameMapTile tile) { tiles.at(y).at(x) = tile; revision++; }
+		void MarkChanged() { revision++; }
+		std::uint32_t GetRevision() { return revision; }
+
 		GameMapLayerType& GetLayerType() { return layer_type; }
 
 		int GetWidthTiles() { return width_tiles; }
@@ -47,18 +55,29 @@ class GameMapLayer {
 
 		std::string& GetTileSetName() { return tileset_name; }
 
+		int GetTileSize() { return tile_size; }
+
 		size_t GetTileCount() { return width_tiles * height_tiles; }
 
+		// Empty tiles and tiles covered by an opaque tile of a layer above, set by GameMap::UpdateOcclusion. Renderers skip them.
+		void SetHiddenTiles(std::vector<bool> hidden_tiles) { if(hidden_tiles != hidden) { hidden = std::move(hidden_tiles); revision++; } }
+		bool IsTileHidden(size_t x, size_t y) { return hidden.empty() == false && hidden[(y * width_tiles) + x]; }
+
 	private:
 		GameMapLayerType layer_type;
 
 		std::vector<std::vector<GameMapTile>> tiles;
 
+		// One flag per tile, row by row, empty when nothing is hidden.
+		std::vector<bool> hidden;
+
 		std::string tileset_name;
 
 		size_t width_tiles, height_tiles;
 
 		int tile_size;
+
+		std::uint32_t revision = 0;
 };
 
 #endif /* __GAME_MAP_LAYER_HPP__ */
\ No newline at end of file
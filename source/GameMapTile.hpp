@@ -19,17 +19,28 @@
 #define __GAME_MAP_TILE_HPP__
 
 // STL
+#include <cstdint>
 #include <string>
 
+// Flip bits as stored by LDtk in a tile's "f" field.
+enum GameMapTileFlip : std::uint8_t {
+	GameMapTileFlipNone = 0,
+	GameMapTileFlipX    = 1,
+	GameMapTileFlipY    = 2
+};
+
 class GameMapTile {
 
 	public:
-		GameMapTile(int tileset_index) : tileset_index(tileset_index) { }
+		GameMapTile(int tileset_index, std::uint8_t flip = GameMapTileFlipNone) : tileset_index(tileset_index), flip(flip) { }
 
 		int GetTileSetIndex() { return tileset_index; }
+		std::uint8_t GetFlip() { return flip; }
 
 	private:
 		int tileset_index;
+
+		std::uint8_t flip;
 };
 
 #endif /* __GAME_MAP_TILE_HPP__ */
\ No newline at end of file
@@ -0,0 +1,303 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// GLAD2
+#include <glad/egl.h>
+#include <glad/gl.h>
+
+// SDL2
+#include "SDL.h"
+#include "SDL_image.h"
+
+#include "HeadlessContext.hpp"
+
+// EGL_EXT_platform_base and EGL_MESA_platform_surfaceless, GLAD isn't generated with them.
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+typedef EGLDisplay (EGLAPIENTRYP PFNEGLGETPLATFORMDISPLAYEXTPROC)(EGLenum platform, void* native_display, const EGLint* attribute_list);
+
+// Extension strings are space separated, match whole names only.
+static bool HasExtension(const char* extensions, const char* name) {
+
+	if(extensions == nullptr) {
+		return false;
+	}
+
+	size_t name_length = std::strlen(name);
+
+	for(const char* match = std::strstr(extensions, name); match != nullptr; match = std::strstr(match + 1, name)) {
+		bool starts_word = (match == extensions || match[-1] == ' ');
+		bool ends_word = (match[name_length] == ' ' || match[name_length] == '\0');
+
+		if(starts_word && ends_word) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+HeadlessContext::HeadlessContext() : display(nullptr), context(nullptr), surface(nullptr),
+									 framebuffer_id(0), color_renderbuffer_id(0), depth_renderbuffer_id(0),
+									 width(0), height(0), is_created(false) {
+
+}
+
+bool HeadlessContext::Create(std::uint32_t width, std::uint32_t height) {
+
+	if(is_created) {
+		std::cout << "HeadlessContext: Tried to re-create a context.\n";
+		return false;
+	}
+
+	this->width = width;
+	this->height = height;
+
+	// Client functions first, display functions are loaded again once there is a display.
+	if(gladLoaderLoadEGL(EGL_NO_DISPLAY) == 0) {
+		std::cout << "HeadlessContext: Failed to load libEGL.\n";
+		return false;
+	}
+
+	EGLDisplay egl_display = EGL_NO_DISPLAY;
+
+	// Without a display GLAD only knows EGL 1.0, fetch the EGL_EXT_platform_base entry point directly.
+	if(HasExtension(eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS), "EGL_MESA_platform_surfaceless")) {
+
+		PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+		if(get_platform_display != nullptr) {
+			egl_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+		}
+	}
+
+	if(egl_display == EGL_NO_DISPLAY) {
+		egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint egl_major = 0, egl_minor = 0;
+
+	if(egl_display == EGL_NO_DISPLAY || eglInitialize(egl_display, &egl_major, &egl_minor) == EGL_FALSE) {
+		std::cout << "HeadlessContext: Failed to initialize an EGL display. eglGetError(): 0x" << std::hex << eglGetError() << std::dec << "\n";
+		return false;
+	}
+
+	display = egl_display;
+
+	gladLoaderLoadEGL(egl_display);
+
+	bool surfaceless = HasExtension(eglQueryString(egl_display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+
+	const EGLint config_attributes[] = {
+		EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_NONE
+	};
+
+	EGLConfig egl_config = nullptr;
+	EGLint config_count = 0;
+
+	if(eglChooseConfig(egl_display, config_attributes, &egl_config, 1, &config_count) == EGL_FALSE || config_count == 0) {
+		std::cout << "HeadlessContext: No EGL config for desktop OpenGL.\n";
+		Destroy();
+		return false;
+	}
+
+	if(eglBindAPI(EGL_OPENGL_API) == EGL_FALSE) {
+		std::cout << "HeadlessContext: Failed to bind the desktop OpenGL API.\n";
+		Destroy();
+		return false;
+	}
+
+	const EGLint context_attributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 5,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	context = eglCreateContext(egl_display, egl_config, EGL_NO_CONTEXT, context_attributes);
+
+	if(context == EGL_NO_CONTEXT) {
+		context = nullptr;
+		std::cout << "HeadlessContext: Failed to create an OpenGL 4.5 core context. eglGetError(): 0x" << std::hex << eglGetError() << std::dec << "\n";
+		Destroy();
+		return false;
+	}
+
+	// Drawing never goes to the surface, it only exists for drivers that need one to make a context current.
+	if(surfaceless == false) {
+
+		const EGLint surface_attributes[] = {
+			EGL_WIDTH, static_cast<EGLint>(width),
+			EGL_HEIGHT, static_cast<EGLint>(height),
+			EGL_NONE
+		};
+
+		surface = eglCreatePbufferSurface(egl_display, egl_config, surface_attributes);
+
+		if(surface == EGL_NO_SURFACE) {
+			surface = nullptr;
+			std::cout << "HeadlessContext: Failed to create a pbuffer surface. eglGetError(): 0x" << std::hex << eglGetError() << std::dec << "\n";
+			Destroy();
+			return false;
+		}
+	}
+
+	EGLSurface egl_surface = (surface != nullptr) ? surface : EGL_NO_SURFACE;
+
+	if(eglMakeCurrent(egl_display, egl_surface, egl_surface, context) == EGL_FALSE) {
+		std::cout << "HeadlessContext: Failed to make the context current. eglGetError(): 0x" << std::hex << eglGetError() << std::dec << "\n";
+		Destroy();
+		return false;
+	}
+
+	if(gladLoadGL((GLADloadfunc) eglGetProcAddress) == 0) {
+		std::cout << "HeadlessContext: Failed to load OpenGL.\n";
+		Destroy();
+		return false;
+	}
+
+	std::cout << "HeadlessContext: EGL " << egl_major << "." << egl_minor << (surfaceless ? ", surfaceless" : ", pbuffer") << ", " << glGetString(GL_RENDERER) << ".\n";
+
+	glCreateRenderbuffers(1, &color_renderbuffer_id);
+	glNamedRenderbufferStorage(color_renderbuffer_id, GL_RGBA8, width, height);
+
+	glCreateRenderbuffers(1, &depth_renderbuffer_id);
+	glNamedRenderbufferStorage(depth_renderbuffer_id, GL_DEPTH24_STENCIL8, width, height);
+
+	glCreateFramebuffers(1, &framebuffer_id);
+	glNamedFramebufferRenderbuffer(framebuffer_id, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_renderbuffer_id);
+	glNamedFramebufferRenderbuffer(framebuffer_id, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_renderbuffer_id);
+
+	if(glCheckNamedFramebufferStatus(framebuffer_id, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "HeadlessContext: Offscreen framebuffer is incomplete.\n";
+		Destroy();
+		return false;
+	}
+
+	// Stays bound, everything drawn "to the screen" lands here.
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
+
+	// Without a surface the viewport starts out empty.
+	glViewport(0, 0, width, height);
+
+	is_created = true;
+
+	return true;
+}
+
+void HeadlessContext::Destroy() {
+
+	if(framebuffer_id != 0) {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &framebuffer_id);
+		glDeleteRenderbuffers(1, &color_renderbuffer_id);
+		glDeleteRenderbuffers(1, &depth_renderbuffer_id);
+		framebuffer_id = color_renderbuffer_id = depth_renderbuffer_id = 0;
+	}
+
+	if(display != nullptr) {
+
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+		if(surface != nullptr) {
+			eglDestroySurface(display, surface);
+		}
+
+		if(context != nullptr) {
+			eglDestroyContext(display, context);
+		}
+
+		eglTerminate(display);
+	}
+
+	gladLoaderUnloadEGL();
+
+	display = context = surface = nullptr;
+
+	is_created = false;
+}
+
+void HeadlessContext::ReadPixels(std::vector<std::uint8_t>& pixels) {
+
+	pixels.resize(width * height * 4);
+
+	std::uint32_t row_size = width * 4;
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glNamedFramebufferReadBuffer(framebuffer_id, GL_COLOR_ATTACHMENT0);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	// GL rows start at the bottom.
+	std::vector<std::uint8_t> row(row_size);
+
+	for(std::uint32_t y = 0; y < height / 2; y++) {
+		std::uint8_t* top = &pixels[y * row_size];
+		std::uint8_t* bottom = &pixels[(height - 1 - y) * row_size];
+
+		std::memcpy(row.data(), top, row_size);
+		std::memcpy(top, bottom, row_size);
+		std::memcpy(bottom, row.data(), row_size);
+	}
+}
+
+bool HeadlessContext::SavePNG(const std::vector<std::uint8_t>& pixels, const std::string& filename) {
+
+	SDL_Surface* frame_surface = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<std::uint8_t*>(pixels.data()), width, height, 32, width * 4, SDL_PIXELFORMAT_RGBA32);
+
+	if(frame_surface == NULL) {
+		std::cout << "HeadlessContext: Failed to wrap frame in a surface. SDL_GetError(): " << SDL_GetError() << "\n";
+		return false;
+	}
+
+	bool success = (IMG_SavePNG(frame_surface, filename.c_str()) == 0);
+
+	if(success == false) {
+		std::cout << "HeadlessContext: Failed to save \"" << filename << "\". IMG_GetError(): " << IMG_GetError() << "\n";
+	}
+
+	SDL_FreeSurface(frame_surface);
+
+	return success;
+}
+
+std::uint64_t HeadlessContext::Checksum(const std::vector<std::uint8_t>& pixels) {
+
+	std::uint64_t hash = 0xCBF29CE484222325ull;
+
+	for(std::uint8_t byte : pixels) {
+		hash ^= byte;
+		hash *= 0x100000001B3ull;
+	}
+
+	return hash;
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEADLESS_CONTEXT_HPP__
+#define __HEADLESS_CONTEXT_HPP__
+
+// STL
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * OpenGL 4.5 core context without a window, for machines with no display.
+ *
+ * Uses EGL through GLAD2, with Mesa's surfaceless platform when it is available (which
+ * llvmpipe supports), otherwise the default display. The context is made current without a
+ * surface if EGL_KHR_surfaceless_context is supported, or with a pbuffer otherwise. Either
+ * way rendering goes into an offscreen framebuffer with RGBA8 color and depth/stencil, bound
+ * for the lifetime of the context.
+ */
+class HeadlessContext {
+
+	public:
+		HeadlessContext();
+
+		// Creates the context and a width x height framebuffer, then makes both current and loads GL.
+		bool Create(std::uint32_t width, std::uint32_t height);
+		void Destroy();
+
+		// Read back the framebuffer as RGBA8, top row first like an SDL surface.
+		void ReadPixels(std::vector<std::uint8_t>& pixels);
+		bool SavePNG(const std::vector<std::uint8_t>& pixels, const std::string& filename);
+
+		// 64-bit FNV-1a, stable across runs and platforms for golden image comparisons.
+		static std::uint64_t Checksum(const std::vector<std::uint8_t>& pixels);
+
+		std::uint32_t GetFramebufferID() { return framebuffer_id; }
+		std::uint32_t GetWidth()         { return width; }
+		std::uint32_t GetHeight()        { return height; }
+		bool          IsSurfaceless()    { return surface == nullptr; }
+		bool          IsCreated()        { return is_created; }
+
+	private:
+		// EGL handles, kept opaque so EGL headers stay out of the rest of the game.
+		void* display;
+		void* context;
+		void* surface;
+
+		std::uint32_t framebuffer_id;
+		std::uint32_t color_renderbuffer_id;
+		std::uint32_t depth_renderbuffer_id;
+
+		std::uint32_t width, height;
+
+		bool is_created;
+};
+
+#endif /* __HEADLESS_CONTEXT_HPP__ */
\ No newline at end of file
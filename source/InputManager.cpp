@@ -101,6 +101,33 @@ void InputManager::HandleKeyboardInputPress() {
         case SDL_SCANCODE_ESCAPE:
             owner->RequestExit();
             break;
+        case SDL_SCANCODE_F1:
+            owner->CycleTileRenderMode();
+            break;
+        case SDL_SCANCODE_F2:
+            owner->ToggleDepthPasses();
+            break;
+        case SDL_SCANCODE_F3:
+            owner->ToggleProfilerOverlay();
+            break;
+        case SDL_SCANCODE_UP:
+            owner->GetCamera().Move(glm::vec2(0.0f, -16.0f));
+            break;
+        case SDL_SCANCODE_DOWN:
+            owner->GetCamera().Move(glm::vec2(0.0f, 16.0f));
+            break;
+        case SDL_SCANCODE_LEFT:
+            owner->GetCamera().Move(glm::vec2(-16.0f, 0.0f));
+            break;
+        case SDL_SCANCODE_RIGHT:
+            owner->GetCamera().Move(glm::vec2(16.0f, 0.0f));
+            break;
+        case SDL_SCANCODE_EQUALS:
+            owner->GetCamera().SetZoom(owner->GetCamera().GetZoom() * 2.0f);
+            break;
+        case SDL_SCANCODE_MINUS:
+            owner->GetCamera().SetZoom(owner->GetCamera().GetZoom() * 0.5f);
+            break;
         case SDL_SCANCODE_LSHIFT:
             modifier_left_shift = true;
             break;
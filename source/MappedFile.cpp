@@ -0,0 +1,151 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : data(nullptr), size(0), file_handle(INVALID_HANDLE_VALUE), mapping_handle(NULL) {
+
+}
+
+bool MappedFile::Open(const char* filename) {
+
+	Close();
+
+	file_handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+	if(file_handle == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER file_size;
+
+	if(GetFileSizeEx(file_handle, &file_size) == FALSE || file_size.QuadPart == 0) {
+		Close();
+		return false;
+	}
+
+	mapping_handle = CreateFileMappingA(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if(mapping_handle == NULL) {
+		Close();
+		return false;
+	}
+
+	data = static_cast<const std::uint8_t*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+
+	if(data == nullptr) {
+		Close();
+		return false;
+	}
+
+	size = static_cast<size_t>(file_size.QuadPart);
+
+	return true;
+}
+
+void MappedFile::Close() {
+
+	if(data != nullptr) {
+		UnmapViewOfFile(data);
+		data = nullptr;
+	}
+
+	if(mapping_handle != NULL) {
+		CloseHandle(mapping_handle);
+		mapping_handle = NULL;
+	}
+
+	if(file_handle != INVALID_HANDLE_VALUE) {
+		CloseHandle(file_handle);
+		file_handle = INVALID_HANDLE_VALUE;
+	}
+
+	size = 0;
+}
+
+#else
+
+MappedFile::MappedFile() : data(nullptr), size(0), file_descriptor(-1) {
+
+}
+
+bool MappedFile::Open(const char* filename) {
+
+	Close();
+
+	file_descriptor = open(filename, O_RDONLY);
+
+	if(file_descriptor == -1) {
+		return false;
+	}
+
+	struct stat file_status;
+
+	if(fstat(file_descriptor, &file_status) != 0 || file_status.st_size == 0) {
+		Close();
+		return false;
+	}
+
+	void* mapping = mmap(nullptr, static_cast<size_t>(file_status.st_size), PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+
+	if(mapping == MAP_FAILED) {
+		Close();
+		return false;
+	}
+
+	data = static_cast<const std::uint8_t*>(mapping);
+	size = static_cast<size_t>(file_status.st_size);
+
+	return true;
+}
+
+void MappedFile::Close() {
+
+	if(data != nullptr) {
+		munmap(const_cast<std::uint8_t*>(data), size);
+		data = nullptr;
+	}
+
+	if(file_descriptor != -1) {
+		close(file_descriptor);
+		file_descriptor = -1;
+	}
+
+	size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+	Close();
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __MAPPED_FILE_HPP__
+#define __MAPPED_FILE_HPP__
+
+// STL
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Read-only memory mapping of a whole file.
+ *
+ * The mapping is released by Close() or the destructor, pointers from GetData()
+ * are only valid until then.
+ */
+class MappedFile {
+
+	public:
+		MappedFile();
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const char* filename);
+		void Close();
+
+		bool IsOpen() { return data != nullptr; }
+
+		const std::uint8_t* GetData() { return data; }
+		size_t GetSize() { return size; }
+
+	private:
+		const std::uint8_t* data;
+		size_t size;
+
+#ifdef _WIN32
+		void* file_handle;
+		void* mapping_handle;
+#else
+		int file_descriptor;
+#endif
+};
+
+#endif /* __MAPPED_FILE_HPP__ */
\ No newline at end of file
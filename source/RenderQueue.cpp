@@ -0,0 +1,342 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// GLAD2
+#include <glad/gl.h>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "ArrayRenderer.hpp"
+#include "Camera.hpp"
+#include "GameMapLayer.hpp"
+#include "RenderQueue.hpp"
+#include "RenderState.hpp"
+#include "SpriteRenderer.hpp"
+#include "Texture2D.hpp"
+#include "TextureAtlas.hpp"
+#include "TileLayerRenderer.hpp"
+#include "TileMapRenderer.hpp"
+#include "WorldTileRenderer.hpp"
+
+// Difference between the depth values of neighbouring keys, 4096 per layer.
+static const float key_depth_step = 1.0f / static_cast<float>((256 << 12) + 1);
+
+// Layer and depth of a key as a depth value, later keys nearer. Depths past 4095 within a layer
+// share a value, blended draws are still in order there and opaque ones just lose early rejection.
+static float GetKeyDepth(std::uint64_t key) {
+
+	std::uint64_t layer = key >> 56;
+	std::uint64_t depth = std::min<std::uint64_t>((key >> 40) & 0xFFFF, 4095);
+
+	return 1.0f - static_cast<float>((layer << 12) + depth + 1) * key_depth_step;
+}
+
+RenderQueue::RenderQueue(ArrayRenderer* array_renderer, SpriteRenderer* sprite_renderer, TileLayerRenderer* tile_layer_renderer, TileMapRenderer* tile_map_renderer, WorldTileRenderer* world_tile_renderer) :
+						 array_renderer(array_renderer), sprite_renderer(sprite_renderer), tile_layer_renderer(tile_layer_renderer), tile_map_renderer(tile_map_renderer), world_tile_renderer(world_tile_renderer),
+						 use_depth_passes(true), command_count(0) {
+
+}
+
+std::uint64_t RenderQueue::MakeKey(std::uint8_t layer, std::uint16_t depth, RenderBlendMode blend, std::uint32_t shader_id, std::uint32_t texture_id) {
+
+	std::uint64_t key = 0;
+
+	key |= static_cast<std::uint64_t>(layer) << 56;
+	key |= static_cast<std::uint64_t>(depth) << 40;
+	key |= static_cast<std::uint64_t>(static_cast<std::uint8_t>(blend) & 0xF) << 36;
+	key |= static_cast<std::uint64_t>(shader_id & 0xFFF) << 24;
+	key |= static_cast<std::uint64_t>(texture_id & 0xFFFFFF);
+
+	return key;
+}
+
+void RenderQueue::Submit(std::uint64_t key, const RenderCommand& command) {
+	sort_entries.push_back({ key, static_cast<std::uint32_t>(commands.size()) });
+	commands.push_back(command);
+}
+
+void RenderQueue::SubmitSprite(std::uint8_t layer, std::uint16_t depth, Texture2D& texture, glm::vec2 position, glm::vec2 size, float rotation, glm::vec3 color, RenderBlendMode blend) {
+	Submit(MakeKey(layer, depth, blend, sprite_renderer->GetShaderID(), texture.GetID()),
+		   { RenderCommandType::Sprite, blend, texture, nullptr, 0, glm::vec2(0.0f), glm::vec2(1.0f), position, size, rotation, color, { 0, 0, 0, 0 }, false });
+}
+
+void RenderQueue::SubmitSpriteRegion(std::uint8_t layer, std::uint16_t depth, TextureRegion& region, glm::vec2 position, glm::vec2 size, glm::vec3 color, RenderBlendMode blend) {
+	Submit(MakeKey(layer, depth, blend, sprite_renderer->GetShaderID(), region.texture.GetID()),
+		   { RenderCommandType::SpriteRegion, blend, region.texture, nullptr, 0, region.uv_min, region.uv_max, position, size, 0.0f, color, { 0, 0, 0, 0 }, false });
+}
+
+void RenderQueue::SubmitTile(std::uint8_t layer, std::uint16_t depth, Texture2D& texture, std::uint32_t subimage, glm::vec2 position, glm::vec2 size, glm::vec3 color, RenderBlendMode blend) {
+	Submit(MakeKey(layer, depth, blend, array_renderer->GetShaderID(), texture.GetID()),
+		   { RenderCommandType::TileArray, blend, texture, nullptr, subimage, glm::vec2(0.0f), glm::vec2(1.0f), position, size, 0.0f, color, { 0, 0, 0, 0 }, false });
+}
+
+void RenderQueue::SubmitTileLayer(std::uint8_t layer, std::uint16_t depth, GameMapLayer& map_layer, Texture2D& texture, glm::vec2 position, glm::vec3 color, RenderBlendMode blend, const TileRange* visible_tiles) {
+	Submit(MakeKey(layer, depth, blend, tile_layer_renderer->GetShaderID(), texture.GetID()),
+		   { RenderCommandType::TileLayer, blend, texture, &map_layer, 0, glm::vec2(0.0f), glm::vec2(1.0f), position, glm::vec2(0.0f), 0.0f, color, (visible_tiles != nullptr) ? *visible_tiles : TileRange { 0, 0, 0, 0 }, visible_tiles != nullptr });
+}
+
+void RenderQueue::SubmitTileMap(std::uint8_t layer, std::uint16_t depth, GameMapLayer& map_layer, Texture2D& texture, glm::vec2 position, glm::vec3 color, RenderBlendMode blend, const TileRange* visible_tiles) {
+	Submit(MakeKey(layer, depth, blend, tile_map_renderer->GetShaderID(), texture.GetID()),
+		   { RenderCommandType::TileMap, blend, texture, &map_layer, 0, glm::vec2(0.0f), glm::vec2(1.0f), position, glm::vec2(0.0f), 0.0f, color, (visible_tiles != nullptr) ? *visible_tiles : TileRange { 0, 0, 0, 0 }, visible_tiles != nullptr });
+}
+
+void RenderQueue::SubmitWorld(std::uint8_t layer, std::uint16_t depth, RenderBlendMode blend) {
+	Submit(MakeKey(layer, depth, blend, world_tile_renderer->GetShaderID(), 0),
+		   { RenderCommandType::World, blend, Texture2D(), nullptr, 0, glm::vec2(0.0f), glm::vec2(1.0f), glm::vec2(0.0f), glm::vec2(0.0f), 0.0f, glm::vec3(1.0f), TileRange { 0, 0, 0, 0 }, false });
+}
+
+void RenderQueue::RadixSort() {
+
+	// LSD radix sort, one byte per pass. Stable, so equal keys keep submission order.
+	size_t count = sort_entries.size();
+	sort_scratch.resize(count);
+
+	SortEntry* source = sort_entries.data();
+	SortEntry* destination = sort_scratch.data();
+
+	for(int shift = 0; shift < 64; shift += 8) {
+
+		size_t offsets[256];
+		std::memset(offsets, 0, sizeof(offsets));
+
+		for(size_t i = 0; i < count; i++) {
+			offsets[(source[i].key >> shift) & 0xFF]++;
+		}
+
+		// Every key has the same byte here, nothing to reorder.
+		if(offsets[(source[0].key >> shift) & 0xFF] == count) {
+			continue;
+		}
+
+		size_t total = 0;
+
+		for(size_t bucket = 0; bucket < 256; bucket++) {
+			size_t bucket_count = offsets[bucket];
+			offsets[bucket] = total;
+			total += bucket_count;
+		}
+
+		for(size_t i = 0; i < count; i++) {
+			destination[offsets[(source[i].key >> shift) & 0xFF]++] = source[i];
+		}
+
+		std::swap(source, destination);
+	}
+
+	if(source != sort_entries.data()) {
+		std::memcpy(sort_entries.data(), source, count * sizeof(SortEntry));
+	}
+}
+
+void RenderQueue::ApplyBlend(RenderBlendMode blend) {
+
+	if(blend == RenderBlendMode::Opaque) {
+		RenderState::SetCapability(GL_BLEND, false);
+	} else {
+		RenderState::SetCapability(GL_BLEND, true);
+		RenderState::SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+}
+
+void RenderQueue::Flush() {
+
+	command_count = static_cast<std::uint32_t>(commands.size());
+
+	if(commands.empty()) {
+		return;
+	}
+
+	RadixSort();
+
+	if(use_depth_passes) {
+		DrawDepthPasses();
+	} else {
+		DrawInOrder();
+	}
+
+	commands.clear();
+	sort_entries.clear();
+}
+
+void RenderQueue::DrawInOrder() {
+
+	// SpriteRenderer re-sorts its batch by texture, so each layer and depth inside a run
+	// of sprites gets its own sort_layer to keep the queue's order.
+	bool in_sprite_run = false;
+	RenderBlendMode sprite_run_blend = RenderBlendMode::Alpha;
+	std::int32_t sprite_sort_layer = 0;
+	std::uint64_t sprite_order_bits = 0;
+
+	const std::uint64_t order_mask = 0xFFFFFFF000000000ull;
+
+	for(size_t i = 0; i < sort_entries.size(); i++) {
+
+		RenderCommand& command = commands[sort_entries[i].index];
+
+		bool is_sprite = (command.type == RenderCommandType::Sprite || command.type == RenderCommandType::SpriteRegion);
+
+		// Batched sprites are drawn when the run ends, so the blend state has to hold for the whole run.
+		if(in_sprite_run && (is_sprite == false || command.blend != sprite_run_blend)) {
+			sprite_renderer->Flush();
+			in_sprite_run = false;
+		}
+
+		ApplyBlend(command.blend);
+
+		if(is_sprite) {
+			if(in_sprite_run == false) {
+				in_sprite_run = true;
+				sprite_run_blend = command.blend;
+				sprite_sort_layer = 0;
+				sprite_order_bits = sort_entries[i].key & order_mask;
+			} else if((sort_entries[i].key & order_mask) != sprite_order_bits) {
+				sprite_sort_layer++;
+				sprite_order_bits = sort_entries[i].key & order_mask;
+			}
+		}
+
+		DrawCommand(command, RenderPass::All, sprite_sort_layer, GetKeyDepth(sort_entries[i].key));
+	}
+
+	if(in_sprite_run) {
+		sprite_renderer->Flush();
+	}
+}
+
+void RenderQueue::DrawDepthPasses() {
+
+	RenderState::SetCapability(GL_DEPTH_TEST, true);
+
+	RenderState::SetDepthMask(true);
+	RenderState::SetDepthFunc(GL_LESS);
+	ApplyBlend(RenderBlendMode::Opaque);
+	DrawDepthPass(true);
+
+	// Equal depth passes, blended geometry draws over opaque geometry of its own layer and depth.
+	RenderState::SetDepthMask(false);
+	RenderState::SetDepthFunc(GL_LEQUAL);
+	ApplyBlend(RenderBlendMode::Alpha);
+	DrawDepthPass(false);
+
+	// Leave the state as anything drawn after the queue, i.e. the UI, expects it.
+	RenderState::SetDepthMask(true);
+	RenderState::SetDepthRange(0.0f, 1.0f);
+	RenderState::SetCapability(GL_DEPTH_TEST, false);
+}
+
+void RenderQueue::DrawDepthPass(bool is_opaque_pass) {
+
+	size_t count = sort_entries.size();
+
+	// A sprite run is drawn when it ends, so it can't span more than one depth value.
+	bool in_sprite_run = false;
+	float sprite_run_depth = 0.0f;
+
+	for(size_t n = 0; n < count; n++) {
+
+		// Opaque geometry front to back, the rest back to front.
+		size_t i = is_opaque_pass ? (count - 1 - n) : n;
+
+		RenderCommand& command = commands[sort_entries[i].index];
+		RenderPass pass = RenderPass::All;
+
+		if(SelectPass(command, is_opaque_pass, pass) == false) {
+			continue;
+		}
+
+		bool is_sprite = (command.type == RenderCommandType::Sprite || command.type == RenderCommandType::SpriteRegion);
+
+		float depth = GetKeyDepth(sort_entries[i].key);
+
+		if(in_sprite_run && (is_sprite == false || depth != sprite_run_depth)) {
+			sprite_renderer->Flush();
+			in_sprite_run = false;
+		}
+
+		// Everything is drawn at z = 0, a collapsed depth range moves it to the key's depth.
+		// The world places each of its layers itself.
+		if(command.type == RenderCommandType::World) {
+			RenderState::SetDepthRange(0.0f, 1.0f);
+		} else {
+			RenderState::SetDepthRange(depth, depth);
+		}
+
+		if(is_sprite) {
+			in_sprite_run = true;
+			sprite_run_depth = depth;
+		}
+
+		DrawCommand(command, pass, 0, depth);
+	}
+
+	if(in_sprite_run) {
+		sprite_renderer->Flush();
+	}
+}
+
+bool RenderQueue::SelectPass(RenderCommand& command, bool is_opaque_pass, RenderPass& pass) {
+
+	bool is_opaque = (command.blend == RenderBlendMode::Opaque) || (command.type == RenderCommandType::TileArray && command.texture.IsSubImageOpaque(command.subimage));
+
+	// Entirely opaque commands are done in the opaque pass.
+	if(is_opaque) {
+		pass = RenderPass::All;
+		return is_opaque_pass;
+	}
+
+	// Whole layers are split between both passes by the tile renderers.
+	if(command.type == RenderCommandType::TileLayer || command.type == RenderCommandType::TileMap || command.type == RenderCommandType::World) {
+		pass = is_opaque_pass ? RenderPass::Opaque : RenderPass::Translucent;
+		return true;
+	}
+
+	pass = RenderPass::All;
+	return is_opaque_pass == false;
+}
+
+void RenderQueue::DrawCommand(RenderCommand& command, RenderPass pass, std::int32_t sprite_sort_layer, float depth) {
+
+	switch(command.type) {
+		case RenderCommandType::Sprite:
+			sprite_renderer->DrawSprite(command.texture, command.position, command.size, command.rotation, command.color, sprite_sort_layer);
+			break;
+		case RenderCommandType::SpriteRegion:
+			sprite_renderer->DrawSpriteRegion(command.texture, command.position, command.size, command.uv_min, command.uv_max, command.color, sprite_sort_layer);
+			break;
+		case RenderCommandType::TileArray:
+			array_renderer->DrawArray(command.texture, command.subimage, command.position, command.size, 0.0f, command.color);
+			break;
+		case RenderCommandType::TileLayer:
+			tile_layer_renderer->DrawLayer(*command.map_layer, command.texture, command.position, command.color, command.has_visible_tiles ? &command.visible_tiles : nullptr, pass);
+			break;
+		case RenderCommandType::TileMap:
+			tile_map_renderer->DrawLayer(*command.map_layer, command.texture, command.position, command.color, command.has_visible_tiles ? &command.visible_tiles : nullptr, pass);
+			break;
+		case RenderCommandType::World:
+			world_tile_renderer->Draw(pass, depth, key_depth_step);
+			break;
+	}
+}
@@ -0,0 +1,150 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RENDER_QUEUE_HPP__
+#define __RENDER_QUEUE_HPP__
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "ArrayRenderer.hpp"
+#include "Camera.hpp"
+#include "GameMapLayer.hpp"
+#include "RenderState.hpp"
+#include "SpriteRenderer.hpp"
+#include "Texture2D.hpp"
+#include "TextureAtlas.hpp"
+#include "TileLayerRenderer.hpp"
+#include "TileMapRenderer.hpp"
+#include "WorldTileRenderer.hpp"
+
+enum class RenderBlendMode : std::uint8_t {
+	Opaque = 0,
+	Alpha = 1
+};
+
+enum class RenderCommandType : std::uint8_t {
+	Sprite,
+	SpriteRegion,
+	TileArray,
+	TileLayer,
+	TileMap,
+	World
+};
+
+/**
+ * Collects draws from anywhere in the frame and submits them in sort key order.
+ *
+ * Each command gets a 64-bit key, most significant first:
+ *
+ *   63..56  layer    coarse draw order (background, world, foreground, ...)
+ *   55..40  depth    order inside a layer, lower draws first
+ *   39..36  blend    RenderBlendMode, opaque before blended at the same depth
+ *   35..24  shader   program name
+ *   23..0   texture  texture name
+ *
+ * Flush() radix sorts the keys once and executes the commands, so everything sharing
+ * a layer and depth is grouped by program and texture. Runs of sprites go through the
+ * SpriteRenderer batch as one flush.
+ *
+ * With depth passes enabled (the default, needs a depth buffer) the layer and depth of
+ * every key are mapped to a depth value through glDepthRange, later ones nearer and the
+ * same in every Flush(). Opaque geometry (opaque tiles, tile map pixels with full alpha
+ * and RenderBlendMode::Opaque commands) is drawn first, front to back with depth writes
+ * and no blending, so the depth test rejects whatever it covers. The rest is drawn back
+ * to front with blending and depth testing but no depth writes, which gives the same
+ * picture as painter's order.
+ *
+ * A World command draws all of a WorldTileRenderer's layers at once. Its layers take the
+ * depths that following depth values of its key would get.
+ */
+class RenderQueue {
+
+	public:
+		RenderQueue(ArrayRenderer* array_renderer, SpriteRenderer* sprite_renderer, TileLayerRenderer* tile_layer_renderer, TileMapRenderer* tile_map_renderer, WorldTileRenderer* world_tile_renderer);
+
+		static std::uint64_t MakeKey(std::uint8_t layer, std::uint16_t depth, RenderBlendMode blend, std::uint32_t shader_id, std::uint32_t texture_id);
+
+		void SubmitSprite(std::uint8_t layer, std::uint16_t depth, Texture2D& texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f), float rotation = 0.0f, glm::vec3 color = glm::vec3(1.0f), RenderBlendMode blend = RenderBlendMode::Alpha);
+		void SubmitSpriteRegion(std::uint8_t layer, std::uint16_t depth, TextureRegion& region, glm::vec2 position, glm::vec2 size, glm::vec3 color = glm::vec3(1.0f), RenderBlendMode blend = RenderBlendMode::Alpha);
+		void SubmitTile(std::uint8_t layer, std::uint16_t depth, Texture2D& texture, std::uint32_t subimage, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f), glm::vec3 color = glm::vec3(1.0f), RenderBlendMode blend = RenderBlendMode::Alpha);
+		void SubmitTileLayer(std::uint8_t layer, std::uint16_t depth, GameMapLayer& map_layer, Texture2D& texture, glm::vec2 position = glm::vec2(0.0f), glm::vec3 color = glm::vec3(1.0f), RenderBlendMode blend = RenderBlendMode::Alpha, const TileRange* visible_tiles = nullptr);
+		void SubmitTileMap(std::uint8_t layer, std::uint16_t depth, GameMapLayer& map_layer, Texture2D& texture, glm::vec2 position = glm::vec2(0.0f), glm::vec3 color = glm::vec3(1.0f), RenderBlendMode blend = RenderBlendMode::Alpha, const TileRange* visible_tiles = nullptr);
+		// Whatever the WorldTileRenderer was last updated with, its layers use depth and the values after it.
+		void SubmitWorld(std::uint8_t layer, std::uint16_t depth, RenderBlendMode blend = RenderBlendMode::Alpha);
+
+		// Sort and draw everything submitted since the last flush.
+		void Flush();
+
+		void SetDepthPasses(bool enabled) { use_depth_passes = enabled; }
+		bool IsUsingDepthPasses() { return use_depth_passes; }
+
+		std::uint32_t GetCommandCount() { return command_count; }
+
+	private:
+		struct RenderCommand {
+			RenderCommandType type;
+			RenderBlendMode blend;
+			Texture2D texture;
+			GameMapLayer* map_layer;
+			std::uint32_t subimage;
+			glm::vec2 uv_min;
+			glm::vec2 uv_max;
+			glm::vec2 position;
+			glm::vec2 size;
+			float rotation;
+			glm::vec3 color;
+			TileRange visible_tiles;
+			bool has_visible_tiles;
+		};
+
+		struct SortEntry {
+			std::uint64_t key;
+			std::uint32_t index;
+		};
+
+		ArrayRenderer* array_renderer;
+		SpriteRenderer* sprite_renderer;
+		TileLayerRenderer* tile_layer_renderer;
+		TileMapRenderer* tile_map_renderer;
+		WorldTileRenderer* world_tile_renderer;
+
+		std::vector<RenderCommand> commands;
+		std::vector<SortEntry> sort_entries;
+		std::vector<SortEntry> sort_scratch;
+
+		bool use_depth_passes;
+
+		// Statistics of the last Flush().
+		std::uint32_t command_count;
+
+		void Submit(std::uint64_t key, const RenderCommand& command);
+		void RadixSort();
+		void ApplyBlend(RenderBlendMode blend);
+		void DrawCommand(RenderCommand& command, RenderPass pass, std::int32_t sprite_sort_layer, float depth);
+		void DrawInOrder();
+		void DrawDepthPasses();
+		void DrawDepthPass(bool is_opaque_pass);
+		bool SelectPass(RenderCommand& command, bool is_opaque_pass, RenderPass& pass);
+};
+
+#endif /* __RENDER_QUEUE_HPP__ */
\ No newline at end of file
@@ -0,0 +1,281 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <cstdint>
+#include <map>
+#include <utility>
+
+// GLAD2
+#include <glad/gl.h>
+
+#include "RenderState.hpp"
+
+// Never a valid GL name, used for state that hasn't been seen yet.
+static const std::uint32_t unknown_state = 0xFFFFFFFF;
+
+std::uint32_t RenderState::program = unknown_state;
+std::uint32_t RenderState::textures[RenderState::texture_unit_count] = { };
+std::uint32_t RenderState::vertex_array = unknown_state;
+std::map<std::uint32_t, std::uint32_t> RenderState::buffers;
+std::map<std::pair<std::uint32_t, std::uint32_t>, std::uint32_t> RenderState::indexed_buffers;
+std::map<std::pair<std::uint32_t, std::uint32_t>, std::pair<std::uint32_t, std::uint32_t>> RenderState::indexed_buffer_ranges;
+std::map<std::uint32_t, bool> RenderState::capabilities;
+std::uint32_t RenderState::blend_source_factor = unknown_state;
+std::uint32_t RenderState::blend_destination_factor = unknown_state;
+std::uint32_t RenderState::depth_func = unknown_state;
+std::uint32_t RenderState::depth_mask = unknown_state;
+float RenderState::depth_range_near = 0.0f;
+float RenderState::depth_range_far = 1.0f;
+bool RenderState::is_depth_range_known = false;
+
+std::uint32_t RenderState::issued_calls = 0;
+std::uint32_t RenderState::skipped_calls = 0;
+std::uint32_t RenderState::frame_issued_calls = 0;
+std::uint32_t RenderState::frame_skipped_calls = 0;
+
+void RenderState::BeginFrame() {
+	frame_issued_calls = issued_calls;
+	frame_skipped_calls = skipped_calls;
+
+	issued_calls = 0;
+	skipped_calls = 0;
+}
+
+void RenderState::Invalidate() {
+
+	program = unknown_state;
+	vertex_array = unknown_state;
+
+	for(std::uint32_t i = 0; i < texture_unit_count; i++) {
+		textures[i] = unknown_state;
+	}
+
+	buffers.clear();
+	indexed_buffers.clear();
+	indexed_buffer_ranges.clear();
+	capabilities.clear();
+
+	blend_source_factor = unknown_state;
+	blend_destination_factor = unknown_state;
+
+	depth_func = unknown_state;
+	depth_mask = unknown_state;
+	is_depth_range_known = false;
+}
+
+bool RenderState::Update(std::uint32_t& shadow, std::uint32_t value) {
+
+	if(shadow == value) {
+		skipped_calls++;
+		return false;
+	}
+
+	shadow = value;
+	issued_calls++;
+	return true;
+}
+
+void RenderState::UseProgram(std::uint32_t program_id) {
+	if(Update(program, program_id)) {
+		glUseProgram(program_id);
+	}
+}
+
+void RenderState::BindTexture(std::uint32_t texture_unit, std::uint32_t texture_id) {
+
+	// Units past the shadowed range are passed straight through.
+	if(texture_unit >= texture_unit_count) {
+		issued_calls++;
+		glBindTextureUnit(texture_unit, texture_id);
+		return;
+	}
+
+	if(Update(textures[texture_unit], texture_id)) {
+		glBindTextureUnit(texture_unit, texture_id);
+	}
+}
+
+void RenderState::BindVertexArray(std::uint32_t vertex_array_id) {
+	if(Update(vertex_array, vertex_array_id)) {
+		glBindVertexArray(vertex_array_id);
+	}
+}
+
+void RenderState::BindBuffer(std::uint32_t target, std::uint32_t buffer_id) {
+
+	auto found = buffers.find(target);
+
+	if(found == buffers.end()) {
+		found = buffers.insert(std::make_pair(target, unknown_state)).first;
+	}
+
+	if(Update(found->second, buffer_id)) {
+		glBindBuffer(target, buffer_id);
+	}
+}
+
+void RenderState::BindBufferBase(std::uint32_t target, std::uint32_t index, std::uint32_t buffer_id) {
+
+	auto key = std::make_pair(target, index);
+	auto found = indexed_buffers.find(key);
+
+	if(found == indexed_buffers.end()) {
+		found = indexed_buffers.insert(std::make_pair(key, unknown_state)).first;
+	}
+
+	// A range of the same buffer is a different binding.
+	if(indexed_buffer_ranges.erase(key) > 0) {
+		found->second = unknown_state;
+	}
+
+	if(Update(found->second, buffer_id)) {
+		glBindBufferBase(target, index, buffer_id);
+
+		// Binding an indexed target also binds the generic one.
+		buffers[target] = buffer_id;
+	}
+}
+
+void RenderState::BindBufferRange(std::uint32_t target, std::uint32_t index, std::uint32_t buffer_id, std::uint32_t offset, std::uint32_t size) {
+
+	auto key = std::make_pair(target, index);
+	auto range = std::make_pair(offset, size);
+
+	auto found = indexed_buffers.find(key);
+	auto found_range = indexed_buffer_ranges.find(key);
+
+	if(found != indexed_buffers.end() && found->second == buffer_id && found_range != indexed_buffer_ranges.end() && found_range->second == range) {
+		skipped_calls++;
+		return;
+	}
+
+	indexed_buffers[key] = buffer_id;
+	indexed_buffer_ranges[key] = range;
+	issued_calls++;
+
+	glBindBufferRange(target, index, buffer_id, offset, size);
+
+	// Binding an indexed target also binds the generic one.
+	buffers[target] = buffer_id;
+}
+
+void RenderState::SetCapability(std::uint32_t capability, bool enabled) {
+
+	auto found = capabilities.find(capability);
+
+	if(found != capabilities.end() && found->second == enabled) {
+		skipped_calls++;
+		return;
+	}
+
+	capabilities[capability] = enabled;
+	issued_calls++;
+
+	if(enabled) {
+		glEnable(capability);
+	} else {
+		glDisable(capability);
+	}
+}
+
+void RenderState::SetBlendFunc(std::uint32_t source_factor, std::uint32_t destination_factor) {
+
+	if(blend_source_factor == source_factor && blend_destination_factor == destination_factor) {
+		skipped_calls++;
+		return;
+	}
+
+	blend_source_factor = source_factor;
+	blend_destination_factor = destination_factor;
+	issued_calls++;
+
+	glBlendFunc(source_factor, destination_factor);
+}
+
+void RenderState::SetDepthFunc(std::uint32_t depth_func) {
+	if(Update(RenderState::depth_func, depth_func)) {
+		glDepthFunc(depth_func);
+	}
+}
+
+void RenderState::SetDepthMask(bool enabled) {
+	if(Update(depth_mask, enabled ? GL_TRUE : GL_FALSE)) {
+		glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+	}
+}
+
+void RenderState::SetDepthRange(float near_value, float far_value) {
+
+	if(is_depth_range_known && depth_range_near == near_value && depth_range_far == far_value) {
+		skipped_calls++;
+		return;
+	}
+
+	depth_range_near = near_value;
+	depth_range_far = far_value;
+	is_depth_range_known = true;
+	issued_calls++;
+
+	glDepthRangef(near_value, far_value);
+}
+
+void RenderState::DeleteProgram(std::uint32_t program_id) {
+
+	if(program == program_id) {
+		program = unknown_state;
+	}
+
+	glDeleteProgram(program_id);
+}
+
+void RenderState::DeleteTexture(std::uint32_t texture_id) {
+
+	for(std::uint32_t i = 0; i < texture_unit_count; i++) {
+		if(textures[i] == texture_id) {
+			textures[i] = unknown_state;
+		}
+	}
+
+	glDeleteTextures(1, &texture_id);
+}
+
+void RenderState::DeleteVertexArray(std::uint32_t vertex_array_id) {
+
+	if(vertex_array == vertex_array_id) {
+		vertex_array = unknown_state;
+	}
+
+	glDeleteVertexArrays(1, &vertex_array_id);
+}
+
+void RenderState::DeleteBuffer(std::uint32_t buffer_id) {
+
+	for(auto& buffer : buffers) {
+		if(buffer.second == buffer_id) {
+			buffer.second = unknown_state;
+		}
+	}
+
+	for(auto& buffer : indexed_buffers) {
+		if(buffer.second == buffer_id) {
+			buffer.second = unknown_state;
+		}
+	}
+
+	glDeleteBuffers(1, &buffer_id);
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RENDER_STATE_HPP__
+#define __RENDER_STATE_HPP__
+
+// STL
+#include <cstdint>
+#include <map>
+#include <utility>
+
+// Which part of a draw to issue when opaque and translucent geometry are drawn in separate passes.
+enum class RenderPass : std::uint8_t {
+	All,
+	Opaque,     // Only what is fully opaque, drawn without blending.
+	Translucent // Everything else.
+};
+
+/**
+ * Shadows the bound GL state so redundant binds never reach the driver.
+ *
+ * Every bind, program switch and blend change in the renderers goes through here.
+ * A call is only issued when it changes the shadowed value, otherwise it is counted
+ * as skipped. Objects must also be deleted through here, GL unbinds a deleted object
+ * and its name can be handed out again, so a stale cached name would skip a real bind.
+ *
+ * Anything that changes state behind RenderState's back must call Invalidate().
+ */
+class RenderState {
+
+	public:
+		// Call once per frame, keeps the previous frame's counts for GetIssuedCalls/GetSkippedCalls.
+		static void BeginFrame();
+
+		// Forget everything, the next call of each kind is always issued.
+		static void Invalidate();
+
+		static void UseProgram(std::uint32_t program_id);
+		static void BindTexture(std::uint32_t texture_unit, std::uint32_t texture_id);
+		static void BindVertexArray(std::uint32_t vertex_array_id);
+		static void BindBuffer(std::uint32_t target, std::uint32_t buffer_id);
+		static void BindBufferBase(std::uint32_t target, std::uint32_t index, std::uint32_t buffer_id);
+		static void BindBufferRange(std::uint32_t target, std::uint32_t index, std::uint32_t buffer_id, std::uint32_t offset, std::uint32_t size);
+
+		static void SetCapability(std::uint32_t capability, bool enabled);
+		static void SetBlendFunc(std::uint32_t source_factor, std::uint32_t destination_factor);
+		static void SetDepthFunc(std::uint32_t depth_func);
+		static void SetDepthMask(bool enabled);
+		static void SetDepthRange(float near_value, float far_value);
+
+		static void DeleteProgram(std::uint32_t program_id);
+		static void DeleteTexture(std::uint32_t texture_id);
+		static void DeleteVertexArray(std::uint32_t vertex_array_id);
+		static void DeleteBuffer(std::uint32_t buffer_id);
+
+		// Counts of the last complete frame.
+		static std::uint32_t GetIssuedCalls()  { return frame_issued_calls; }
+		static std::uint32_t GetSkippedCalls() { return frame_skipped_calls; }
+
+	private:
+		RenderState() { }
+
+		static const std::uint32_t texture_unit_count = 32;
+
+		static std::uint32_t program;
+		static std::uint32_t textures[texture_unit_count];
+		static std::uint32_t vertex_array;
+		static std::map<std::uint32_t, std::uint32_t> buffers;
+		static std::map<std::pair<std::uint32_t, std::uint32_t>, std::uint32_t> indexed_buffers;
+		static std::map<std::pair<std::uint32_t, std::uint32_t>, std::pair<std::uint32_t, std::uint32_t>> indexed_buffer_ranges;
+		static std::map<std::uint32_t, bool> capabilities;
+		static std::uint32_t blend_source_factor;
+		static std::uint32_t blend_destination_factor;
+		static std::uint32_t depth_func;
+		static std::uint32_t depth_mask;
+		static float depth_range_near;
+		static float depth_range_far;
+		static bool is_depth_range_known;
+
+		static std::uint32_t issued_calls;
+		static std::uint32_t skipped_calls;
+		static std::uint32_t frame_issued_calls;
+		static std::uint32_t frame_skipped_calls;
+
+		// Returns true if the call has to be issued, and shadows the new value.
+		static bool Update(std::uint32_t& shadow, std::uint32_t value);
+};
+
+#endif /* __RENDER_STATE_HPP__ */
\ No newline at end of file
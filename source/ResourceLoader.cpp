@@ -15,12 +15,24 @@
  * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
 
 // GLAD2
 #include <glad/gl.h>
@@ -37,23 +49,49 @@
 // json
 #include <nlohmann/json.hpp>
 
+#include "CookedTexture.hpp"
 #include "Font.hpp"
 #include "GameMap.hpp"
 #include "GameMapLayer.hpp"
 #include "GameMapTile.hpp"
 #include "GameWorld.hpp"
+#include "MappedFile.hpp"
 #include "MusicTrack.hpp"
+#include "RenderState.hpp"
 #include "ResourceLoader.hpp"
+#include "SDFFont.hpp"
 #include "Shader.hpp"
 #include "SoundEffect.hpp"
+#include "StreamBuffer.hpp"
 #include "Texture2D.hpp"
+#include "TextureAtlas.hpp"
 
 std::map<std::string, Font>        ResourceLoader::fonts;
 std::map<std::string, GameWorld>   ResourceLoader::game_worlds;
 std::map<std::string, MusicTrack>  ResourceLoader::music_tracks;
-std::map<std::string, Shader>      ResourceLoader::shaders;
+std::map<std::string, SDFFont>     ResourceLoader::sdf_fonts;
+std::map<std::pair<std::string, std::uint32_t>, Shader> ResourceLoader::shaders;
 std::map<std::string, SoundEffect> ResourceLoader::sound_effects;
 std::map<std::string, Texture2D>   ResourceLoader::textures;
+std::map<std::string, TextureAtlas> ResourceLoader::texture_atlases;
+
+std::map<std::pair<std::string, std::uint32_t>, ResourceLoader::PendingShader> ResourceLoader::pending_shaders;
+
+std::deque<std::shared_ptr<ResourceLoader::PendingTexture>> ResourceLoader::pending_textures;
+std::deque<std::shared_ptr<ResourceLoader::PendingTexture>> ResourceLoader::texture_decode_queue;
+std::vector<std::thread>  ResourceLoader::texture_workers;
+std::mutex                ResourceLoader::texture_mutex;
+std::condition_variable   ResourceLoader::texture_condition;
+bool                      ResourceLoader::texture_workers_stopping = false;
+
+StreamBuffer* ResourceLoader::texture_staging_buffer = nullptr;
+std::uint32_t ResourceLoader::texture_upload_budget = 2 * 1024 * 1024;
+Texture2D     ResourceLoader::placeholder_texture;
+Texture2D     ResourceLoader::placeholder_texture_array;
+
+std::uint32_t ResourceLoader::shader_cache_hits = 0;
+std::uint32_t ResourceLoader::shader_cache_misses = 0;
+double        ResourceLoader::shader_load_time = 0.0;
 
 Font ResourceLoader::LoadFont(const char* filename, int point_size, std::string font_name) {
 	fonts[font_name] = LoadFontFromFile(filename, point_size);
@@ -64,6 +102,15 @@ Font ResourceLoader::GetFont(std::string font_name) {
 	return fonts[font_name];
 }
 
+SDFFont ResourceLoader::LoadSDFFont(const char* filename, std::string font_name, int base_size) {
+	sdf_fonts[font_name] = LoadSDFFontFromFile(filename, base_size);
+	return sdf_fonts[font_name];
+}
+
+SDFFont ResourceLoader::GetSDFFont(std::string font_name) {
+	return sdf_fonts[font_name];
+}
+
 GameWorld& ResourceLoader::LoadGameWorld(const char* filename, std::string game_world_name) {
 	game_worlds[game_world_name] = LoadGameWorldFromFile(filename);
 	return game_worlds[game_world_name];
@@ -82,13 +129,54 @@ MusicTrack ResourceLoader::GetMusicTrack(std::string music_track_name) {
 	return music_tracks[music_track_name];
 }
 
-Shader ResourceLoader::LoadShader(const char* vertex_shader_filename, const char* fragment_shader_filename, const char* geometry_shader_filename, std::string shader_name) {
-	shaders[shader_name] = LoadShaderFromFile(vertex_shader_filename, fragment_shader_filename, geometry_shader_filename);
-	return shaders[shader_name];
+Shader ResourceLoader::LoadShader(const char* vertex_shader_filename, const char* fragment_shader_filename, const char* geometry_shader_filename, std::string shader_name, std::uint32_t variant) {
+	auto key = std::make_pair(shader_name, variant);
+	shaders[key] = LoadShaderFromFile(vertex_shader_filename, fragment_shader_filename, geometry_shader_filename, variant);
+	return shaders[key];
 }
 
-Shader ResourceLoader::GetShader(std::string name) {
-	return shaders[name];
+Shader ResourceLoader::GetShader(std::string name, std::uint32_t variant) {
+	return shaders[std::make_pair(name, variant)];
+}
+
+void ResourceLoader::LoadShaderAsync(const char* vertex_shader_filename, const char* fragment_shader_filename, const char* geometry_shader_filename, std::string shader_name, std::uint32_t variant) {
+
+	PendingShader pending_shader;
+
+	auto key = std::make_pair(shader_name, variant);
+	shaders[key] = LoadShaderFromFile(vertex_shader_filename, fragment_shader_filename, geometry_shader_filename, variant, &pending_shader);
+
+	if(shaders[key].IsPending()) {
+		pending_shaders[key] = pending_shader;
+	}
+}
+
+bool ResourceLoader::PollShaders() {
+
+	for(auto pending = pending_shaders.begin(); pending != pending_shaders.end();) {
+
+		Shader& shader = shaders[pending->first];
+
+		if(shader.PollCompile()) {
+			FinishShaderLoad(shader, pending->second, false);
+			pending = pending_shaders.erase(pending);
+		} else {
+			pending++;
+		}
+	}
+
+	return pending_shaders.empty();
+}
+
+bool ResourceLoader::IsShaderReady(std::string name, std::uint32_t variant) {
+
+	auto shader = shaders.find(std::make_pair(name, variant));
+
+	if(shader == shaders.end()) {
+		return false;
+	}
+
+	return shader->second.IsReady();
 }
 
 SoundEffect ResourceLoader::LoadSoundEffect(const char* filename, std::string sound_effect_name) {
@@ -119,8 +207,156 @@ Texture2D ResourceLoader::GetTexture(std::string name) {
 	return textures[name];
 }
 
+void ResourceLoader::LoadTextureAsync(const char* filename, bool alpha, bool bilinear, std::string texture_name) {
+	LoadTextureArrayAsync(filename, alpha, bilinear, texture_name, 0, 0);
+}
+
+void ResourceLoader::LoadTextureArrayAsync(const char* filename, bool alpha, bool bilinear, std::string texture_name, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y) {
+
+	if(filename == nullptr) {
+		return;
+	}
+
+	StartTextureWorkers();
+
+	std::shared_ptr<PendingTexture> pending_texture = std::make_shared<PendingTexture>();
+
+	pending_texture->name = texture_name;
+	pending_texture->filename = filename;
+	pending_texture->alpha = alpha;
+	pending_texture->bilinear = bilinear;
+	pending_texture->subimage_size_x = subimage_size_x;
+	pending_texture->subimage_size_y = subimage_size_y;
+	pending_texture->decoded = false;
+	pending_texture->failed = false;
+	pending_texture->units_uploaded = 0;
+
+	bool is_array = (subimage_size_x != 0 && subimage_size_y != 0);
+
+	textures[texture_name] = is_array ? placeholder_texture_array : placeholder_texture;
+	pending_textures.push_back(pending_texture);
+
+	{
+		std::lock_guard<std::mutex> lock(texture_mutex);
+		texture_decode_queue.push_back(pending_texture);
+	}
+
+	texture_condition.notify_one();
+}
+
+bool ResourceLoader::PollTextures() {
+
+	if(pending_textures.empty()) {
+		return true;
+	}
+
+	texture_staging_buffer->BeginFrame();
+
+	std::uint32_t budget_left = texture_upload_budget;
+
+	// Textures finish in the order they were submitted in, unless an earlier one is still decoding.
+	for(auto pending = pending_textures.begin(); pending != pending_textures.end() && budget_left != 0;) {
+
+		PendingTexture& pending_texture = **pending;
+
+		bool decoded = false;
+		bool failed = false;
+
+		{
+			std::lock_guard<std::mutex> lock(texture_mutex);
+			decoded = pending_texture.decoded;
+			failed = pending_texture.failed;
+		}
+
+		if(decoded == false) {
+			pending++;
+			continue;
+		}
+
+		// Leave an unloaded texture behind, like a failed synchronous load.
+		if(failed) {
+			textures[pending_texture.name] = Texture2D();
+			pending = pending_textures.erase(pending);
+			continue;
+		}
+
+		if(UploadPendingTexture(pending_texture, budget_left) == false) {
+			break;
+		}
+
+		pending_texture.texture.SetSubImageOpacity(std::move(pending_texture.layer_opacity));
+
+		textures[pending_texture.name] = pending_texture.texture;
+		pending = pending_textures.erase(pending);
+	}
+
+	RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	texture_staging_buffer->EndFrame();
+
+	return pending_textures.empty();
+}
+
+bool ResourceLoader::IsTextureReady(std::string name) {
+
+	for(auto& pending_texture : pending_textures) {
+		if(pending_texture->name == name) {
+			return false;
+		}
+	}
+
+	auto texture = textures.find(name);
+
+	return texture != textures.end() && texture->second.IsLoaded();
+}
+
+TextureAtlas ResourceLoader::LoadTextureAtlas(const std::vector<std::pair<std::string, std::string>>& images, bool bilinear, std::string texture_atlas_name) {
+
+	TextureAtlas texture_atlas;
+
+	for(auto& image : images) {
+
+		SDL_Surface* image_surface = IMG_Load(image.second.c_str());
+
+		if(image_surface == NULL) {
+			std::cout << "ResourceLoader: Failed to load texture from file \"" << image.second << "\". IMG_GetError(): " << IMG_GetError() << "\n";
+			continue;
+		}
+
+		SDL_Surface* rgba_surface = SDL_ConvertSurfaceFormat(image_surface, SDL_PIXELFORMAT_RGBA32, 0);
+		SDL_FreeSurface(image_surface);
+
+		if(rgba_surface == NULL) {
+			std::cout << "ResourceLoader: Failed to convert \"" << image.second << "\". SDL_GetError(): " << SDL_GetError() << "\n";
+			continue;
+		}
+
+		// The atlas expects tightly packed rows.
+		std::vector<std::uint8_t> pixels(rgba_surface->w * rgba_surface->h * 4);
+
+		for(int y = 0; y < rgba_surface->h; y++) {
+			std::memcpy(&pixels[y * rgba_surface->w * 4], static_cast<std::uint8_t*>(rgba_surface->pixels) + (y * rgba_surface->pitch), rgba_surface->w * 4);
+		}
+
+		texture_atlas.AddImage(image.first, rgba_surface->w, rgba_surface->h, pixels.data());
+
+		SDL_FreeSurface(rgba_surface);
+	}
+
+	texture_atlas.Build(bilinear);
+
+	texture_atlases[texture_atlas_name] = texture_atlas;
+	return texture_atlases[texture_atlas_name];
+}
+
+TextureAtlas ResourceLoader::GetTextureAtlas(std::string name) {
+	return texture_atlases[name];
+}
+
 void ResourceLoader::UnloadAll() {
 
+	StopTextureWorkers();
+
 	for(auto font : fonts) {
 		font.second.Delete();
 	}
@@ -129,6 +365,10 @@ void ResourceLoader::UnloadAll() {
 		music_track.second.Delete();
 	}
 
+	for(auto sdf_font : sdf_fonts) {
+		sdf_font.second.Delete();
+	}
+
 	for(auto shader : shaders) {
 		shader.second.Delete();
 	}
@@ -140,6 +380,10 @@ void ResourceLoader::UnloadAll() {
 	for(auto texture : textures) {
 		texture.second.Delete();
 	}
+
+	for(auto texture_atlas : texture_atlases) {
+		texture_atlas.second.Delete();
+	}
 }
 
 Font ResourceLoader::LoadFontFromFile(const char* filename, int point_size) {
@@ -156,6 +400,20 @@ Font ResourceLoader::LoadFontFromFile(const char* filename, int point_size) {
 	return new_font;
 }
 
+SDFFont ResourceLoader::LoadSDFFontFromFile(const char* filename, int base_size) {
+
+	TTF_Font* font = TTF_OpenFont(filename, base_size);
+
+	if(font == nullptr) {
+		std::cout << "ResourceLoader: Failed to load font from file \"" << filename << "\". TTF_GetError(): " << TTF_GetError() << "\n";
+		return SDFFont();
+	}
+
+	SDFFont new_font(font, base_size);
+
+	return new_font;
+}
+
 MusicTrack ResourceLoader::LoadMusicTrackFromFile(const char* filename) {
 
 	MusicTrack music_track;
@@ -186,17 +444,36 @@ GameWorld ResourceLoader::LoadGameWorldFromFile(const char* filename) {
 
 	GameWorld game_world(tile_size);
 
+	// Linear layouts leave worldX and worldY at -1, their levels follow each other.
+	std::string world_layout = input_json.contains("worldLayout") && input_json["worldLayout"].is_string() ? input_json["worldLayout"].get<std::string>() : std::string();
+	int linear_offset = 0;
+
 	if(input_json.contains("levels")) {
 
 		for(auto level : input_json.find<std::string>("levels").value()) {
 
 			std::string level_identifier = level.find<std::string>("identifier").value();
 
-			int level_width = static_cast<int>(level.find<std::string>("pxWid").value()) / tile_size;
-			int level_height = static_cast<int>(level.find<std::string>("pxHei").value()) / tile_size;
+			int level_px_width = static_cast<int>(level.find<std::string>("pxWid").value());
+			int level_px_height = static_cast<int>(level.find<std::string>("pxHei").value());
+			int level_width = level_px_width / tile_size;
+			int level_height = level_px_height / tile_size;
+
+			int world_x = level.contains("worldX") ? static_cast<int>(level["worldX"]) : 0;
+			int world_y = level.contains("worldY") ? static_cast<int>(level["worldY"]) : 0;
+
+			if(world_layout == "LinearHorizontal") {
+				world_x = linear_offset;
+				world_y = 0;
+				linear_offset += level_px_width;
+			} else if(world_layout == "LinearVertical") {
+				world_x = 0;
+				world_y = linear_offset;
+				linear_offset += level_px_height;
+			}
 
 			// Add a GameMap for each level.
-			game_world.GetMaps().push_back(GameMap(tile_size, level_width, level_height));
+			game_world.GetMaps().push_back(GameMap(tile_size, level_width, level_height, world_x, world_y));
 
 			for(auto layer : level.find<std::string>("layerInstances").value()) {
 
@@ -213,10 +490,11 @@ GameWorld ResourceLoader::LoadGameWorldFromFile(const char* filename) {
 					
 						int tile_x = tile["px"].get<std::vector<int>>()[0] / tile_size;
 						int tile_y = tile["px"].get<std::vector<int>>()[1] / tile_size;
+						int tile_flip = static_cast<int>(tile.find<std::string>("f").value());
 
 						// Add a GameMapTile for each tile.
 						//std::cout << "Tile (" << tile_x << "," << tile_y << ") for layer " << layer.find<std::string>("__identifier").value() << " for map " << level_identifier << "." << std::endl;
-						game_world.GetMaps().back().GetLayers().back().GetTiles().at(tile_y).at(tile_x) = GameMapTile(static_cast<int>(tile.find<std::string>("t").value()));
+						game_world.GetMaps().back().GetLayers().back().SetTile(tile_x, tile_y, GameMapTile(static_cast<int>(tile.find<std::string>("t").value()), static_cast<std::uint8_t>(tile_flip)));
 					}
 				}
 			}
@@ -226,7 +504,7 @@ GameWorld ResourceLoader::LoadGameWorldFromFile(const char* filename) {
 	return game_world;
 }
 
-Shader ResourceLoader::LoadShaderFromFile(const char* vertex_shader_filename, const char* fragment_shader_filename, const char* geometry_shader_filename) {
+Shader ResourceLoader::LoadShaderFromFile(const char* vertex_shader_filename, const char* fragment_shader_filename, const char* geometry_shader_filename, std::uint32_t variant, PendingShader* pending_shader) {
 	
 	std::string vertex_shader_source, fragment_shader_source, geometry_shader_source;
 	std::stringstream vertex_shader_stream, fragment_shader_stream, geometry_shader_stream;
@@ -258,15 +536,156 @@ Shader ResourceLoader::LoadShaderFromFile(const char* vertex_shader_filename, co
 
 	Shader shader;
 
-	if(geometry_shader_filename != nullptr) {
-		shader.Compile(vertex_shader_source.c_str(), fragment_shader_source.c_str(), geometry_shader_source.c_str());
-	} else {
-		shader.Compile(vertex_shader_source.c_str(), fragment_shader_source.c_str(), nullptr);
+	PendingShader load;
+	load.filename = vertex_shader_filename;
+	load.variant = variant;
+	load.load_start = SDL_GetPerformanceCounter();
+	load.cache_filename = GetShaderCacheFilename(vertex_shader_source, fragment_shader_source, geometry_shader_source, variant);
+
+	bool cache_hit = LoadShaderBinaryFromFile(shader, load.cache_filename, variant);
+
+	if(cache_hit == false) {
+		const char* geometry_source = (geometry_shader_filename != nullptr) ? geometry_shader_source.c_str() : nullptr;
+
+		// Asynchronous compiles are finished by PollShaders.
+		if(pending_shader != nullptr) {
+			shader.CompileAsync(vertex_shader_source.c_str(), fragment_shader_source.c_str(), geometry_source, variant);
+
+			if(shader.IsPending()) {
+				*pending_shader = load;
+				return shader;
+			}
+		} else {
+			shader.Compile(vertex_shader_source.c_str(), fragment_shader_source.c_str(), geometry_source, variant);
+		}
 	}
 
+	FinishShaderLoad(shader, load, cache_hit);
+
 	return shader;
 }
 
+void ResourceLoader::FinishShaderLoad(Shader& shader, const PendingShader& pending_shader, bool cache_hit) {
+
+	if(cache_hit == false) {
+		SaveShaderBinaryToFile(shader, pending_shader.cache_filename);
+	}
+
+	double load_time = (SDL_GetPerformanceCounter() - pending_shader.load_start) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+
+	if(cache_hit) {
+		shader_cache_hits++;
+	} else {
+		shader_cache_misses++;
+	}
+
+	shader_load_time += load_time;
+
+	std::cout << "ResourceLoader: Shader \"" << pending_shader.filename << "\" (variant " << pending_shader.variant << ") " << (cache_hit ? "loaded from cache" : "compiled") << " in " << load_time << "ms "
+			  << "(cache hits: " << shader_cache_hits << ", misses: " << shader_cache_misses << ", total: " << shader_load_time << "ms).\n";
+}
+
+std::string ResourceLoader::GetShaderCacheFilename(const std::string& vertex_shader_source, const std::string& fragment_shader_source, const std::string& geometry_shader_source, std::uint32_t variant) {
+
+	// Binaries are only valid for the exact driver that produced them.
+	const char* gl_strings[] = {
+		reinterpret_cast<const char*>(glGetString(GL_VENDOR)),
+		reinterpret_cast<const char*>(glGetString(GL_RENDERER)),
+		reinterpret_cast<const char*>(glGetString(GL_VERSION))
+	};
+
+	// 64-bit FNV-1a over every source, the variant and driver string, each terminated by a zero byte.
+	std::uint64_t hash = 0xCBF29CE484222325ULL;
+
+	auto hash_string = [&hash](const char* string) {
+		if(string != nullptr) {
+			for(const char* c = string; *c != '\0'; c++) {
+				hash = (hash ^ static_cast<std::uint8_t>(*c)) * 0x100000001B3ULL;
+			}
+		}
+		hash *= 0x100000001B3ULL;
+	};
+
+	hash_string(vertex_shader_source.c_str());
+	hash_string(fragment_shader_source.c_str());
+	hash_string(geometry_shader_source.c_str());
+	hash_string(std::to_string(variant).c_str());
+
+	for(auto gl_string : gl_strings) {
+		hash_string(gl_string);
+	}
+
+	// SDL creates the per-user directory if needed.
+	char* pref_path = SDL_GetPrefPath("mattRPG", "mattRPG");
+
+	if(pref_path == NULL) {
+		return std::string();
+	}
+
+	std::stringstream cache_filename;
+	cache_filename << pref_path << "shader_" << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+
+	SDL_free(pref_path);
+
+	return cache_filename.str();
+}
+
+bool ResourceLoader::LoadShaderBinaryFromFile(Shader& shader, const std::string& cache_filename, std::uint32_t variant) {
+
+	if(cache_filename.empty()) {
+		return false;
+	}
+
+	std::ifstream cache_file(cache_filename, std::ios::binary);
+
+	if(cache_file.fail()) {
+		return false;
+	}
+
+	std::uint32_t binary_format = 0;
+	cache_file.read(reinterpret_cast<char*>(&binary_format), sizeof(binary_format));
+
+	std::vector<std::uint8_t> binary((std::istreambuf_iterator<char>(cache_file)), std::istreambuf_iterator<char>());
+
+	if(cache_file.bad() || binary.empty()) {
+		return false;
+	}
+
+	if(shader.LoadBinary(binary_format, binary.data(), static_cast<std::int32_t>(binary.size()), variant) == false) {
+		std::cout << "ResourceLoader: Cached shader binary \"" << cache_filename << "\" was rejected, recompiling.\n";
+		return false;
+	}
+
+	return true;
+}
+
+void ResourceLoader::SaveShaderBinaryToFile(Shader& shader, const std::string& cache_filename) {
+
+	GLint binary_format_count = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_format_count);
+
+	if(cache_filename.empty() || binary_format_count == 0) {
+		return;
+	}
+
+	std::uint32_t binary_format = 0;
+	std::vector<std::uint8_t> binary;
+
+	if(shader.GetBinary(binary_format, binary) == false) {
+		return;
+	}
+
+	std::ofstream cache_file(cache_filename, std::ios::binary | std::ios::trunc);
+
+	if(cache_file.fail()) {
+		std::cout << "ResourceLoader: Failed to write shader cache \"" << cache_filename << "\".\n";
+		return;
+	}
+
+	cache_file.write(reinterpret_cast<const char*>(&binary_format), sizeof(binary_format));
+	cache_file.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+}
+
 SoundEffect ResourceLoader::LoadSoundEffectFromFile(const char* filename) {
 	SoundEffect sound_effect;
 	return sound_effect;
@@ -347,6 +766,11 @@ Texture2D ResourceLoader::LoadTextureArrayFromFile(const char* filename, bool al
 		texture.SetFilterMinMax(GL_LINEAR, GL_LINEAR);
 	}
 
+	// Prefer the cooked copy, it is uploaded straight from the mapped file without decoding.
+	if(LoadCookedTextureFromFile(filename, subimage_size_x, subimage_size_y, texture)) {
+		return texture;
+	}
+
 	SDL_Surface* image_surface = IMG_Load(filename);
 
 	if(image_surface == NULL) {
@@ -354,7 +778,21 @@ Texture2D ResourceLoader::LoadTextureArrayFromFile(const char* filename, bool al
 		return texture;
 	}
 
-	texture.GenerateArray(image_surface->w, image_surface->h, subimage_size_x, subimage_size_y, static_cast<std::uint8_t*>(image_surface->pixels));
+	// Tiles are sliced out on the CPU, which needs tightly packed RGBA8 rows.
+	if(image_surface->format->format != SDL_PIXELFORMAT_RGBA32) {
+		SDL_Surface* rgba_surface = SDL_ConvertSurfaceFormat(image_surface, SDL_PIXELFORMAT_RGBA32, 0);
+		SDL_FreeSurface(image_surface);
+		image_surface = rgba_surface;
+
+		if(image_surface == NULL) {
+			std::cout << "ResourceLoader: Failed to convert texture \"" << filename << "\". SDL_GetError(): " << SDL_GetError() << "\n";
+			return texture;
+		}
+	}
+
+	texture.GenerateArray(image_surface->w, image_surface->h, subimage_size_x, subimage_size_y, static_cast<std::uint8_t*>(image_surface->pixels), true);
+
+	SDL_FreeSurface(image_surface);
 
 	return texture;
 }
@@ -376,6 +814,11 @@ Texture2D ResourceLoader::LoadTextureFromFile(const char* filename, bool alpha,
 		texture.SetFilterMinMax(GL_LINEAR, GL_LINEAR);
 	}
 
+	// Prefer the cooked copy, it is uploaded straight from the mapped file without decoding.
+	if(LoadCookedTextureFromFile(filename, 0, 0, texture)) {
+		return texture;
+	}
+
 	SDL_Surface* image_surface = IMG_Load(filename);
 
 	if(image_surface == NULL) {
@@ -386,4 +829,354 @@ Texture2D ResourceLoader::LoadTextureFromFile(const char* filename, bool alpha,
 	texture.Generate(image_surface->w, image_surface->h, static_cast<std::uint8_t*>(image_surface->pixels));
 
 	return texture;
+}
+
+bool ResourceLoader::LoadCookedTextureFromFile(const std::string& filename, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y, Texture2D& texture) {
+
+	MappedFile cooked_file;
+	CookedTextureHeader header;
+
+	if(OpenCookedTexture(filename, subimage_size_x, subimage_size_y, cooked_file, header) == false) {
+		return false;
+	}
+
+	bool wants_array = (subimage_size_x != 0 && subimage_size_y != 0);
+
+	const std::uint8_t* data = cooked_file.GetData() + header.data_offset;
+
+	texture.SetInternalFormat(header.internal_format);
+	texture.SetImageFormat(header.image_format);
+
+	if(wants_array) {
+		texture.GenerateArrayFromLayers(header.source_width, header.source_height, header.layer_width, header.layer_height, header.layer_count, data);
+
+		if(header.internal_format == GL_RGBA8) {
+			texture.SetSubImageOpacity(Texture2D::ClassifyTiles(data, header.layer_width, header.layer_height * header.layer_count, header.layer_width, header.layer_height));
+		}
+	} else {
+		texture.Generate(header.source_width, header.source_height, const_cast<std::uint8_t*>(data));
+	}
+
+	return texture.IsLoaded();
+}
+
+bool ResourceLoader::OpenCookedTexture(const std::string& filename, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y, MappedFile& cooked_file, CookedTextureHeader& header) {
+
+	std::string cooked_filename = filename + ".mtex";
+
+	// Not cooked, the caller falls back to decoding the source image.
+	if(cooked_file.Open(cooked_filename.c_str()) == false) {
+		return false;
+	}
+
+	if(cooked_file.GetSize() < sizeof(CookedTextureHeader)) {
+		std::cout << "ResourceLoader: Cooked texture \"" << cooked_filename << "\" is truncated.\n";
+		return false;
+	}
+
+	std::memcpy(&header, cooked_file.GetData(), sizeof(CookedTextureHeader));
+
+	if(header.magic != cooked_texture_magic || header.version != cooked_texture_version) {
+		std::cout << "ResourceLoader: \"" << cooked_filename << "\" is not a cooked texture of this version, re-run the cooker.\n";
+		return false;
+	}
+
+	if(header.data_offset + header.data_size > cooked_file.GetSize()) {
+		std::cout << "ResourceLoader: Cooked texture \"" << cooked_filename << "\" is truncated.\n";
+		return false;
+	}
+
+	std::uint64_t source_size = 0;
+	std::int64_t source_modified_time = 0;
+
+	// Edited since it was cooked, the source is the one to use. A cooked file shipped without its source is fine.
+	if(GetCookedTextureSourceStamp(filename, source_size, source_modified_time) && (source_size != header.source_size || source_modified_time != header.source_modified_time)) {
+		std::cout << "ResourceLoader: Cooked texture \"" << cooked_filename << "\" is out of date with its source, re-run the cooker.\n";
+		return false;
+	}
+
+	bool wants_array = (subimage_size_x != 0 && subimage_size_y != 0);
+
+	// Cooked with a different tile size than requested, decode the source instead.
+	if(wants_array && (header.layer_count == 0 || header.layer_width != subimage_size_x || header.layer_height != subimage_size_y)) {
+		return false;
+	}
+
+	if(wants_array == false && header.layer_count != 0) {
+		return false;
+	}
+
+	// Data has to cover every layer, block compressed data exactly as glCompressedTextureSubImage* rejects anything else.
+	bool is_compressed = (Texture2D::GetCompressedBlockSize(header.internal_format) != 0);
+
+	std::uint64_t layer_size = is_compressed ? Texture2D::GetCompressedImageSize(header.internal_format, header.layer_width, header.layer_height) : static_cast<std::uint64_t>(header.layer_width) * header.layer_height * 4;
+	std::uint64_t expected_size = layer_size * std::max(header.layer_count, 1u);
+
+	if(header.data_size < expected_size || (is_compressed && header.data_size != expected_size)) {
+		std::cout << "ResourceLoader: Cooked texture \"" << cooked_filename << "\" has the wrong amount of pixel data.\n";
+		return false;
+	}
+
+	return true;
+}
+
+void ResourceLoader::StartTextureWorkers() {
+
+	if(texture_workers.empty() == false) {
+		return;
+	}
+
+	std::uint8_t transparent_pixel[4] = { 0, 0, 0, 0 };
+
+	placeholder_texture = Texture2D();
+	placeholder_texture.Generate(1, 1, transparent_pixel);
+
+	placeholder_texture_array = Texture2D();
+	placeholder_texture_array.GenerateArrayFromLayers(1, 1, 1, 1, 1, transparent_pixel);
+
+	// One region of budget bytes per frame in flight.
+	texture_staging_buffer = new StreamBuffer(texture_upload_budget);
+
+	texture_workers_stopping = false;
+
+	// Leave a core for the render thread.
+	int worker_count = std::min(std::max(SDL_GetCPUCount() - 1, 1), 4);
+
+	for(int i = 0; i < worker_count; i++) {
+		texture_workers.emplace_back(TextureWorker);
+	}
+}
+
+void ResourceLoader::StopTextureWorkers() {
+
+	if(texture_workers.empty()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(texture_mutex);
+		texture_workers_stopping = true;
+		texture_decode_queue.clear();
+	}
+
+	texture_condition.notify_all();
+
+	for(auto& worker : texture_workers) {
+		worker.join();
+	}
+
+	texture_workers.clear();
+
+	// Unfinished textures still point at a placeholder, which is deleted once below.
+	for(auto& pending_texture : pending_textures) {
+		pending_texture->texture.Delete();
+		textures[pending_texture->name] = Texture2D();
+	}
+
+	pending_textures.clear();
+
+	placeholder_texture.Delete();
+	placeholder_texture_array.Delete();
+	placeholder_texture = Texture2D();
+	placeholder_texture_array = Texture2D();
+
+	delete texture_staging_buffer;
+	texture_staging_buffer = nullptr;
+}
+
+void ResourceLoader::TextureWorker() {
+
+	while(true) {
+
+		std::shared_ptr<PendingTexture> pending_texture;
+
+		{
+			std::unique_lock<std::mutex> lock(texture_mutex);
+			texture_condition.wait(lock, [] { return texture_workers_stopping || texture_decode_queue.empty() == false; });
+
+			if(texture_workers_stopping) {
+				return;
+			}
+
+			pending_texture = texture_decode_queue.front();
+			texture_decode_queue.pop_front();
+		}
+
+		bool success = DecodeTexture(*pending_texture);
+
+		std::lock_guard<std::mutex> lock(texture_mutex);
+		pending_texture->failed = (success == false);
+		pending_texture->decoded = true;
+	}
+}
+
+bool ResourceLoader::DecodeTexture(PendingTexture& pending_texture) {
+
+	std::uint32_t subimage_size_x = pending_texture.subimage_size_x;
+	std::uint32_t subimage_size_y = pending_texture.subimage_size_y;
+	CookedTextureHeader& header = pending_texture.header;
+
+	// Cooked data is already in upload order.
+	MappedFile cooked_file;
+
+	if(OpenCookedTexture(pending_texture.filename, subimage_size_x, subimage_size_y, cooked_file, header)) {
+		const std::uint8_t* data = cooked_file.GetData() + header.data_offset;
+		pending_texture.pixels.assign(data, data + header.data_size);
+
+		// Opacity of compressed layers is unknown without decoding them.
+		if(header.layer_count != 0 && header.internal_format == GL_RGBA8) {
+			pending_texture.layer_opacity = Texture2D::ClassifyTiles(pending_texture.pixels.data(), header.layer_width, header.layer_height * header.layer_count, header.layer_width, header.layer_height);
+		}
+
+		return true;
+	}
+
+	SDL_Surface* image_surface = IMG_Load(pending_texture.filename.c_str());
+
+	if(image_surface == NULL) {
+		std::cout << "ResourceLoader: Failed to load texture from file \"" << pending_texture.filename << "\". IMG_GetError(): " << IMG_GetError() << "\n";
+		return false;
+	}
+
+	SDL_Surface* rgba_surface = SDL_ConvertSurfaceFormat(image_surface, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(image_surface);
+
+	if(rgba_surface == NULL) {
+		std::cout << "ResourceLoader: Failed to convert texture \"" << pending_texture.filename << "\". SDL_GetError(): " << SDL_GetError() << "\n";
+		return false;
+	}
+
+	std::uint32_t width = rgba_surface->w;
+	std::uint32_t height = rgba_surface->h;
+
+	std::memset(&header, 0, sizeof(header));
+
+	header.internal_format = GL_RGBA8;
+	header.image_format = GL_RGBA;
+	header.image_type = GL_UNSIGNED_BYTE;
+	header.source_width = width;
+	header.source_height = height;
+
+	if(subimage_size_x != 0 && subimage_size_y != 0) {
+
+		header.layer_width = subimage_size_x;
+		header.layer_height = subimage_size_y;
+		header.layer_count = (width / subimage_size_x) * (height / subimage_size_y);
+
+		if(header.layer_count == 0) {
+			std::cout << "ResourceLoader: \"" << pending_texture.filename << "\" is smaller than one " << subimage_size_x << "x" << subimage_size_y << " tile.\n";
+			SDL_FreeSurface(rgba_surface);
+			return false;
+		}
+
+		pending_texture.pixels.resize(header.layer_count * subimage_size_x * subimage_size_y * 4);
+		Texture2D::SliceTiles(static_cast<std::uint8_t*>(rgba_surface->pixels), width, height, subimage_size_x, subimage_size_y, pending_texture.pixels.data());
+		pending_texture.layer_opacity = Texture2D::ClassifyTiles(pending_texture.pixels.data(), subimage_size_x, subimage_size_y * header.layer_count, subimage_size_x, subimage_size_y);
+	} else {
+
+		header.layer_width = width;
+		header.layer_height = height;
+
+		pending_texture.pixels.resize(width * height * 4);
+
+		for(std::uint32_t y = 0; y < height; y++) {
+			std::memcpy(&pending_texture.pixels[y * width * 4], static_cast<std::uint8_t*>(rgba_surface->pixels) + (y * rgba_surface->pitch), width * 4);
+		}
+	}
+
+	header.data_size = pending_texture.pixels.size();
+
+	SDL_FreeSurface(rgba_surface);
+
+	return true;
+}
+
+bool ResourceLoader::UploadPendingTexture(PendingTexture& pending_texture, std::uint32_t& budget_left) {
+
+	CookedTextureHeader& header = pending_texture.header;
+	Texture2D& texture = pending_texture.texture;
+
+	bool is_array = (header.layer_count != 0);
+
+	if(texture.IsLoaded() == false) {
+
+		if(pending_texture.alpha) {
+			texture.SetInternalFormat(GL_RGBA8);
+			texture.SetImageFormat(GL_RGBA);
+		}
+
+		if(pending_texture.bilinear) {
+			texture.SetFilterMinMax(GL_LINEAR, GL_LINEAR);
+		}
+
+		texture.SetInternalFormat(header.internal_format);
+		texture.SetImageFormat(header.image_format);
+
+		if(is_array) {
+			texture.AllocateArray(header.source_width, header.source_height, header.layer_width, header.layer_height, header.layer_count);
+		} else {
+			texture.Allocate(header.layer_width, header.layer_height);
+		}
+	}
+
+	// Uploads go in units of one layer, one row, or one row of 4x4 blocks.
+	std::uint32_t unit_rows = texture.IsCompressed() ? 4 : 1;
+	std::uint32_t unit_count = is_array ? header.layer_count : (header.layer_height + unit_rows - 1) / unit_rows;
+	std::uint32_t unit_size = 0;
+
+	if(is_array) {
+		unit_size = texture.IsCompressed() ? Texture2D::GetCompressedImageSize(header.internal_format, header.layer_width, header.layer_height) : header.layer_width * header.layer_height * 4;
+	} else {
+		unit_size = texture.IsCompressed() ? Texture2D::GetCompressedImageSize(header.internal_format, header.layer_width, 4) : header.layer_width * 4;
+	}
+
+	while(pending_texture.units_uploaded < unit_count) {
+
+		std::uint32_t units = std::min(unit_count - pending_texture.units_uploaded, budget_left / unit_size);
+		const std::uint8_t* source = pending_texture.pixels.data() + (static_cast<size_t>(pending_texture.units_uploaded) * unit_size);
+		const std::uint8_t* data = source;
+
+		if(units == 0) {
+
+			// A unit bigger than the whole budget gets a frame to itself, straight from client memory.
+			if(budget_left != texture_upload_budget) {
+				return false;
+			}
+
+			units = 1;
+			budget_left = 0;
+
+			RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		} else {
+
+			std::uint32_t offset = 0;
+			void* staging = texture_staging_buffer->Allocate(units * unit_size, 4, offset);
+
+			if(staging != nullptr) {
+				std::memcpy(staging, source, units * unit_size);
+				RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, texture_staging_buffer->GetID());
+				data = reinterpret_cast<const std::uint8_t*>(static_cast<std::uintptr_t>(offset));
+			} else if(texture_staging_buffer->IsMapped()) {
+				return false;
+			} else {
+				RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			}
+
+			budget_left -= units * unit_size;
+		}
+
+		if(is_array) {
+			texture.UploadLayers(pending_texture.units_uploaded, units, data);
+		} else {
+			std::uint32_t y = pending_texture.units_uploaded * unit_rows;
+			texture.UploadRows(y, std::min(units * unit_rows, header.layer_height - y), data);
+		}
+
+		pending_texture.units_uploaded += units;
+	}
+
+	// The pixels aren't needed anymore once every unit is in flight.
+	std::vector<std::uint8_t>().swap(pending_texture.pixels);
+
+	return true;
 }
\ No newline at end of file
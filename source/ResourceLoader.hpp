@@ -19,20 +19,32 @@
 #define __RESOURCE_LOADER_HPP__
 
 // STL
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 // GLM
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
+#include "CookedTexture.hpp"
 #include "Font.hpp"
 #include "GameWorld.hpp"
+#include "MappedFile.hpp"
 #include "MusicTrack.hpp"
+#include "SDFFont.hpp"
 #include "Texture2D.hpp"
+#include "TextureAtlas.hpp"
 #include "Shader.hpp"
 #include "SoundEffect.hpp"
+#include "StreamBuffer.hpp"
 
 class ResourceLoader {
 
@@ -40,14 +52,25 @@ class ResourceLoader {
 		static Font LoadFont(const char* filename, int point_size, std::string font_name);
 		static Font GetFont(std::string name);
 
+		// Distance field fonts are drawn at any size, base_size only sets the rasterized quality.
+		static SDFFont LoadSDFFont(const char* filename, std::string font_name, int base_size = 48);
+		static SDFFont GetSDFFont(std::string name);
+
 		static GameWorld& LoadGameWorld(const char* filename, std::string game_world_name);
 		static GameWorld& GetGameWorld(std::string name);
 
 		static MusicTrack LoadMusicTrack(const char* filename, std::string music_track_name);
 		static MusicTrack GetMusicTrack(std::string name);
 
-		static Shader LoadShader(const char* vertex_shader_filename, const char* fragment_shader_filename, const char* geometry_shader_filename, std::string shader_name);
-		static Shader GetShader(std::string name);
+		// Every variant (a mask of ShaderVariantBits) of a shader is its own program, cached under the same name.
+		static Shader LoadShader(const char* vertex_shader_filename, const char* fragment_shader_filename, const char* geometry_shader_filename, std::string shader_name, std::uint32_t variant = 0);
+		static Shader GetShader(std::string name, std::uint32_t variant = 0);
+
+		// Submit a shader without waiting on the driver. PollShaders must be called once per frame,
+		// it returns true once nothing is pending anymore. GetShader(name).IsReady() is false until linked.
+		static void LoadShaderAsync(const char* vertex_shader_filename, const char* fragment_shader_filename, const char* geometry_shader_filename, std::string shader_name, std::uint32_t variant = 0);
+		static bool PollShaders();
+		static bool IsShaderReady(std::string name, std::uint32_t variant = 0);
 
 		static SoundEffect LoadSoundEffect(const char* filename, std::string sound_effect_name);
 		static SoundEffect GetSoundEffect(std::string name);
@@ -57,26 +80,110 @@ class ResourceLoader {
 		static Texture2D LoadTexture(const char* filename, bool alpha, bool bilinear, std::string texture_name);
 		static Texture2D GetTexture(std::string name);
 
+		// Decode on worker threads and upload through a pixel buffer, a budgeted slice per PollTextures call.
+		// Until then GetTexture(name) returns a transparent placeholder, so fetch it every frame instead of keeping a copy.
+		static void LoadTextureAsync(const char* filename, bool alpha, bool bilinear, std::string texture_name);
+		static void LoadTextureArrayAsync(const char* filename, bool alpha, bool bilinear, std::string texture_name, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y);
+		static bool PollTextures();
+		static bool IsTextureReady(std::string name);
+
+		// Bytes of texture data uploaded per PollTextures, only takes effect before the first asynchronous load.
+		static void SetTextureUploadBudget(std::uint32_t budget) { texture_upload_budget = budget; }
+
+		// Pack several image files, given as (region name, filename) pairs, into one texture.
+		static TextureAtlas LoadTextureAtlas(const std::vector<std::pair<std::string, std::string>>& images, bool bilinear, std::string texture_atlas_name);
+		static TextureAtlas GetTextureAtlas(std::string name);
+
 		static void UnloadAll();
 
+		// Program binary cache statistics, compile time includes cache loads.
+		static std::uint32_t GetShaderCacheHits()   { return shader_cache_hits; }
+		static std::uint32_t GetShaderCacheMisses() { return shader_cache_misses; }
+		static double        GetShaderLoadTime()    { return shader_load_time; }
+
 	private:
 		ResourceLoader() { }
 
+		// Bookkeeping for a shader that is compiled asynchronously.
+		struct PendingShader {
+			std::string filename;
+			std::uint32_t variant;
+			std::string cache_filename;
+			std::uint64_t load_start;
+		};
+
+		// Bookkeeping for a texture that is loaded asynchronously.
+		struct PendingTexture {
+			std::string name;
+			std::string filename;
+			bool alpha;
+			bool bilinear;
+			std::uint32_t subimage_size_x;
+			std::uint32_t subimage_size_y;
+
+			// Written by a worker before decoded is set, header describes pixels like a cooked file would.
+			bool decoded;
+			bool failed;
+			CookedTextureHeader header;
+			std::vector<std::uint8_t> pixels;
+			// Opacity of each array layer, empty for compressed data.
+			std::vector<TileOpacity> layer_opacity;
+
+			// Rows (or rows of blocks) of a 2D texture, or layers of an array texture, uploaded so far.
+			Texture2D texture;
+			std::uint32_t units_uploaded;
+		};
+
 		static Font LoadFontFromFile(const char* filename, int point_size);
+		static SDFFont LoadSDFFontFromFile(const char* filename, int base_size);
 		static GameWorld LoadGameWorldFromFile(const char* filename);
 		static MusicTrack LoadMusicTrackFromFile(const char* filename);
-		static Shader LoadShaderFromFile(const char* vertex_shader_filename, const char* fragment_shader_filename, const char* geometry_shader_filename);
+		static Shader LoadShaderFromFile(const char* vertex_shader_filename, const char* fragment_shader_filename, const char* geometry_shader_filename, std::uint32_t variant, PendingShader* pending_shader = nullptr);
+		static void FinishShaderLoad(Shader& shader, const PendingShader& pending_shader, bool cache_hit);
+		static std::string GetShaderCacheFilename(const std::string& vertex_shader_source, const std::string& fragment_shader_source, const std::string& geometry_shader_source, std::uint32_t variant);
+		static bool LoadShaderBinaryFromFile(Shader& shader, const std::string& cache_filename, std::uint32_t variant);
+		static void SaveShaderBinaryToFile(Shader& shader, const std::string& cache_filename);
 		static SoundEffect LoadSoundEffectFromFile(const char* filename);
 		static Texture2D LoadSubTextureFromFile(const char* filename, bool alpha, bool bilinear, glm::vec2 top_left, glm::vec2 bottom_right);
 		static Texture2D LoadTextureArrayFromFile(const char* filename, bool alpha, bool bilinear, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y);
 		static Texture2D LoadTextureFromFile(const char* filename, bool alpha, bool bilinear);
+		static bool LoadCookedTextureFromFile(const std::string& filename, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y, Texture2D& texture);
+		static bool OpenCookedTexture(const std::string& filename, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y, MappedFile& cooked_file, CookedTextureHeader& header);
+		static void StartTextureWorkers();
+		static void StopTextureWorkers();
+		static void TextureWorker();
+		static bool DecodeTexture(PendingTexture& pending_texture);
+		static bool UploadPendingTexture(PendingTexture& pending_texture, std::uint32_t& budget_left);
 
 		static std::map<std::string, Font>        fonts;
 		static std::map<std::string, GameWorld>   game_worlds;
 		static std::map<std::string, MusicTrack>  music_tracks;
-		static std::map<std::string, Shader>      shaders;
+		static std::map<std::string, SDFFont>     sdf_fonts;
+		static std::map<std::pair<std::string, std::uint32_t>, Shader> shaders;
 		static std::map<std::string, SoundEffect> sound_effects;
 		static std::map<std::string, Texture2D>   textures;
+		static std::map<std::string, TextureAtlas> texture_atlases;
+
+		static std::map<std::pair<std::string, std::uint32_t>, PendingShader> pending_shaders;
+
+		// In submission order, only touched by the render thread.
+		static std::deque<std::shared_ptr<PendingTexture>> pending_textures;
+
+		// Textures waiting for a worker, decoded and failed are also guarded by texture_mutex.
+		static std::deque<std::shared_ptr<PendingTexture>> texture_decode_queue;
+		static std::vector<std::thread> texture_workers;
+		static std::mutex texture_mutex;
+		static std::condition_variable texture_condition;
+		static bool texture_workers_stopping;
+
+		static StreamBuffer* texture_staging_buffer;
+		static std::uint32_t texture_upload_budget;
+		static Texture2D placeholder_texture;
+		static Texture2D placeholder_texture_array;
+
+		static std::uint32_t shader_cache_hits;
+		static std::uint32_t shader_cache_misses;
+		static double        shader_load_time;
 };
 
 #endif /* __RESOURCE_LOADER_HPP__ */
\ No newline at end of file
@@ -0,0 +1,271 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// GLAD2
+#include <glad/gl.h>
+
+// SDL2
+#include "SDL.h"
+#include "SDL_ttf.h"
+
+#include "SDFFont.hpp"
+#include "Texture2D.hpp"
+
+// Offset from a pixel to its nearest seed pixel, used by the distance transform below.
+struct DistancePoint {
+	int dx, dy;
+
+	int DistanceSquared() const { return (dx * dx) + (dy * dy); }
+};
+
+static void CompareDistance(std::vector<DistancePoint>& grid, int width, int height, int x, int y, int offset_x, int offset_y) {
+
+	int other_x = x + offset_x;
+	int other_y = y + offset_y;
+
+	if(other_x < 0 || other_y < 0 || other_x >= width || other_y >= height) {
+		return;
+	}
+
+	DistancePoint other = grid[(other_y * width) + other_x];
+	other.dx += offset_x;
+	other.dy += offset_y;
+
+	if(other.DistanceSquared() < grid[(y * width) + x].DistanceSquared()) {
+		grid[(y * width) + x] = other;
+	}
+}
+
+// 8SSEDT, two raster passes that carry the nearest seed offset across the grid.
+static void PropagateDistance(std::vector<DistancePoint>& grid, int width, int height) {
+
+	for(int y = 0; y < height; y++) {
+		for(int x = 0; x < width; x++) {
+			CompareDistance(grid, width, height, x, y, -1,  0);
+			CompareDistance(grid, width, height, x, y,  0, -1);
+			CompareDistance(grid, width, height, x, y, -1, -1);
+			CompareDistance(grid, width, height, x, y,  1, -1);
+		}
+
+		for(int x = width - 1; x >= 0; x--) {
+			CompareDistance(grid, width, height, x, y, 1, 0);
+		}
+	}
+
+	for(int y = height - 1; y >= 0; y--) {
+		for(int x = width - 1; x >= 0; x--) {
+			CompareDistance(grid, width, height, x, y,  1, 0);
+			CompareDistance(grid, width, height, x, y,  0, 1);
+			CompareDistance(grid, width, height, x, y, -1, 1);
+			CompareDistance(grid, width, height, x, y,  1, 1);
+		}
+
+		for(int x = 0; x < width; x++) {
+			CompareDistance(grid, width, height, x, y, -1, 0);
+		}
+	}
+}
+
+SDFFont::SDFFont() {
+
+}
+
+SDFFont::SDFFont(TTF_Font* font, int base_size, std::uint32_t atlas_size, int spread) : data(std::make_shared<Data>()) {
+
+	data->font = font;
+	data->atlas_size = atlas_size;
+	data->base_size = base_size;
+	data->spread = spread;
+	data->packer = ShelfPacker(atlas_size, atlas_size);
+
+	std::vector<std::uint8_t> empty(atlas_size * atlas_size, 0);
+
+	// Single channel and linearly filtered, the shader thresholds the interpolated distance.
+	data->atlas.SetInternalFormat(GL_R8);
+	data->atlas.SetImageFormat(GL_RED);
+	data->atlas.SetFilterMinMax(GL_LINEAR, GL_LINEAR);
+	data->atlas.Generate(atlas_size, atlas_size, empty.data());
+
+	for(std::uint32_t codepoint = 0x20; codepoint < 0x7F; codepoint++) {
+		GetGlyph(codepoint);
+	}
+}
+
+const SDFFont::Glyph* SDFFont::GetGlyph(std::uint32_t codepoint) {
+
+	if(data == nullptr) {
+		return nullptr;
+	}
+
+	auto found = data->glyphs.find(codepoint);
+
+	if(found != data->glyphs.end()) {
+		return &found->second;
+	}
+
+	Glyph glyph;
+	glyph.uv_min = glm::vec2(0.0f);
+	glyph.uv_max = glm::vec2(0.0f);
+	glyph.offset = glm::vec2(0.0f);
+	glyph.size = glm::vec2(0.0f);
+	glyph.advance = 0.0f;
+
+	if(GenerateGlyph(codepoint, glyph) == false) {
+		// Remember missing glyphs too so they aren't retried every frame.
+		data->glyphs[codepoint] = glyph;
+		return nullptr;
+	}
+
+	data->glyphs[codepoint] = glyph;
+	return &data->glyphs[codepoint];
+}
+
+bool SDFFont::GenerateGlyph(std::uint32_t codepoint, Glyph& glyph) {
+
+	// SDL_ttf glyph functions only take the basic multilingual plane.
+	if(codepoint > 0xFFFF) {
+		return false;
+	}
+
+	int min_x, max_x, min_y, max_y, advance;
+
+	if(TTF_GlyphMetrics(data->font, static_cast<Uint16>(codepoint), &min_x, &max_x, &min_y, &max_y, &advance) != 0) {
+		return false;
+	}
+
+	glyph.advance = static_cast<float>(advance);
+
+	SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+
+	SDL_Surface* glyph_surface = TTF_RenderGlyph_Blended(data->font, static_cast<Uint16>(codepoint), white);
+
+	// Whitespace has nothing to render, only an advance.
+	if(glyph_surface == NULL) {
+		return true;
+	}
+
+	SDL_Surface* rgba_surface = SDL_ConvertSurfaceFormat(glyph_surface, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(glyph_surface);
+
+	if(rgba_surface == NULL) {
+		std::cout << "SDFFont: Failed to convert glyph surface. SDL_GetError(): " << SDL_GetError() << "\n";
+		return false;
+	}
+
+	// The surface covers the whole line height, crop it to the pixels that are actually covered.
+	int surface_width = rgba_surface->w;
+	int surface_height = rgba_surface->h;
+	const std::uint8_t* pixels = static_cast<const std::uint8_t*>(rgba_surface->pixels);
+
+	int crop_min_x = surface_width, crop_min_y = surface_height, crop_max_x = -1, crop_max_y = -1;
+
+	for(int y = 0; y < surface_height; y++) {
+		for(int x = 0; x < surface_width; x++) {
+			if(pixels[(y * rgba_surface->pitch) + (x * 4) + 3] != 0) {
+				crop_min_x = std::min(crop_min_x, x);
+				crop_min_y = std::min(crop_min_y, y);
+				crop_max_x = std::max(crop_max_x, x);
+				crop_max_y = std::max(crop_max_y, y);
+			}
+		}
+	}
+
+	if(crop_max_x < 0) {
+		SDL_FreeSurface(rgba_surface);
+		return true;
+	}
+
+	// Leave room for the field to fall off around the outline.
+	int spread = data->spread;
+	int field_width = (crop_max_x - crop_min_x + 1) + (spread * 2);
+	int field_height = (crop_max_y - crop_min_y + 1) + (spread * 2);
+
+	const int far_away = 0x3FFF;
+
+	// distance_outside finds the nearest covered pixel, distance_inside the nearest uncovered one.
+	std::vector<DistancePoint> distance_outside(field_width * field_height, { far_away, far_away });
+	std::vector<DistancePoint> distance_inside(field_width * field_height, { 0, 0 });
+
+	for(int y = 0; y < field_height; y++) {
+		for(int x = 0; x < field_width; x++) {
+			int source_x = x - spread + crop_min_x;
+			int source_y = y - spread + crop_min_y;
+
+			if(source_x < 0 || source_y < 0 || source_x >= surface_width || source_y >= surface_height) {
+				continue;
+			}
+
+			if(pixels[(source_y * rgba_surface->pitch) + (source_x * 4) + 3] >= 0x80) {
+				distance_outside[(y * field_width) + x] = { 0, 0 };
+				distance_inside[(y * field_width) + x] = { far_away, far_away };
+			}
+		}
+	}
+
+	SDL_FreeSurface(rgba_surface);
+
+	PropagateDistance(distance_outside, field_width, field_height);
+	PropagateDistance(distance_inside, field_width, field_height);
+
+	// Map the signed distance so 0.5 is the outline and the field reaches 0 or 1 at spread pixels.
+	std::vector<std::uint8_t> field(field_width * field_height);
+
+	for(size_t i = 0; i < field.size(); i++) {
+		float distance = std::sqrt(static_cast<float>(distance_outside[i].DistanceSquared())) - std::sqrt(static_cast<float>(distance_inside[i].DistanceSquared()));
+		float value = 0.5f - (distance / (2.0f * spread));
+		field[i] = static_cast<std::uint8_t>(std::min(std::max(value, 0.0f), 1.0f) * 255.0f);
+	}
+
+	std::uint32_t atlas_x = 0;
+	std::uint32_t atlas_y = 0;
+
+	if(data->packer.Pack(field_width, field_height, atlas_x, atlas_y) == false) {
+		std::cout << "SDFFont: Glyph atlas is full.\n";
+		return false;
+	}
+
+	data->atlas.Update(atlas_x, atlas_y, field_width, field_height, field.data());
+
+	float atlas_size = static_cast<float>(data->atlas_size);
+
+	glyph.uv_min = glm::vec2(atlas_x / atlas_size, atlas_y / atlas_size);
+	glyph.uv_max = glm::vec2((atlas_x + field_width) / atlas_size, (atlas_y + field_height) / atlas_size);
+	glyph.offset = glm::vec2(crop_min_x - spread, crop_min_y - spread);
+	glyph.size = glm::vec2(field_width, field_height);
+
+	return true;
+}
+
+void SDFFont::Delete() {
+
+	if(data == nullptr) {
+		return;
+	}
+
+	data->atlas.Delete();
+	TTF_CloseFont(data->font);
+
+	data->glyphs.clear();
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SDF_FONT_HPP__
+#define __SDF_FONT_HPP__
+
+// STL
+#include <cstdint>
+#include <map>
+#include <memory>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+// SDL2
+#include "SDL_ttf.h"
+
+#include "ShelfPacker.hpp"
+#include "Texture2D.hpp"
+
+/**
+ * A font face stored as signed distance fields.
+ *
+ * Glyphs are rasterized once at base_size, turned into a distance field and packed
+ * into a single channel atlas. The field stores 0.5 on the outline and falls off over
+ * spread pixels, so the same atlas can be drawn crisp at any size by thresholding it in
+ * the shader. Printable ASCII is generated on creation, anything else on first use.
+ *
+ * Copies share the same atlas and glyphs.
+ */
+class SDFFont {
+
+	public:
+		// All sizes are in base_size pixels, multiply by (draw size / base size) when drawing.
+		struct Glyph {
+			glm::vec2 uv_min;
+			glm::vec2 uv_max;
+			glm::vec2 offset;
+			glm::vec2 size;
+			float advance;
+		};
+
+		SDFFont();
+		SDFFont(TTF_Font* font, int base_size, std::uint32_t atlas_size = 1024, int spread = 6);
+
+		const Glyph* GetGlyph(std::uint32_t codepoint);
+
+		void Delete();
+
+		bool IsLoaded() { return data != nullptr; }
+
+		Texture2D& GetAtlas() { return data->atlas; }
+		int GetBaseSize() { return data->base_size; }
+		int GetLineSkip() { return TTF_FontLineSkip(data->font); }
+
+	private:
+		struct Data {
+			TTF_Font* font;
+			Texture2D atlas;
+			std::uint32_t atlas_size;
+			int base_size;
+			int spread;
+
+			ShelfPacker packer;
+
+			std::map<std::uint32_t, Glyph> glyphs;
+		};
+
+		std::shared_ptr<Data> data;
+
+		bool GenerateGlyph(std::uint32_t codepoint, Glyph& glyph);
+};
+
+#endif /* __SDF_FONT_HPP__ */
\ No newline at end of file
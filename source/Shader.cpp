@@ -15,7 +15,12 @@
  * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
 
 // GLAD2
 #include <glad/gl.h>
@@ -24,97 +29,484 @@
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
+#include "RenderState.hpp"
 #include "Shader.hpp"
 
 Shader& Shader::Use() {
-	glUseProgram(program_id);
+	RenderState::UseProgram(program_id);
 	return *this;
 }
 
-void Shader::Compile(const char* vertex_source, const char* fragment_source, const char* geometry_source) {
+// GL_KHR_parallel_shader_compile isn't part of the generated GLAD2 loader.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
-	int result = 0;
-	char result_log[1024];
-	unsigned int vertex_id, fragment_id, geometry_id;
+static bool HasParallelShaderCompile() {
+
+	static int has_extension = -1;
+
+	if(has_extension == -1) {
+		has_extension = 0;
+
+		GLint extension_count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+
+		for(GLint i = 0; i < extension_count; i++) {
+			std::string extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+
+			if(extension == "GL_KHR_parallel_shader_compile" || extension == "GL_ARB_parallel_shader_compile") {
+				has_extension = 1;
+				break;
+			}
+		}
+	}
+
+	return has_extension == 1;
+}
+
+// Define names of the ShaderVariantBits, in bit order.
+static const char* variant_define_names[] = {
+	"ALPHA_TEST",
+	"TRANSLUCENT_ONLY"
+};
+
+std::string Shader::AddVariantDefines(const std::string& source, std::uint32_t variant) {
+
+	if(variant == 0) {
+		return source;
+	}
+
+	std::string defines;
+
+	for(size_t bit = 0; bit < sizeof(variant_define_names) / sizeof(variant_define_names[0]); bit++) {
+		if(variant & (1u << bit)) {
+			defines += std::string("#define ") + variant_define_names[bit] + "\n";
+		}
+	}
+
+	// #version has to stay the first line, the defines go right after it.
+	size_t insert_at = 0;
+	size_t version = source.find("#version");
+
+	if(version != std::string::npos) {
+		size_t line_end = source.find('\n', version);
+		insert_at = (line_end == std::string::npos) ? source.size() : line_end + 1;
+
+		if(line_end == std::string::npos) {
+			defines = "\n" + defines;
+		}
+
+		// Keep compile errors pointing at the lines of the file.
+		size_t next_line = std::count(source.begin(), source.begin() + insert_at, '\n') + 1;
+		defines += "#line " + std::to_string(next_line) + "\n";
+	}
+
+	return source.substr(0, insert_at) + defines + source.substr(insert_at);
+}
+
+void Shader::Compile(const char* vertex_source, const char* fragment_source, const char* geometry_source, std::uint32_t variant) {
+
+	CompileAsync(vertex_source, fragment_source, geometry_source, variant);
+
+	if(is_pending) {
+		FinishCompile();
+	}
+}
+
+void Shader::CompileAsync(const char* vertex_source, const char* fragment_source, const char* geometry_source, std::uint32_t variant) {
+
+	is_ready = false;
+	is_pending = false;
+
+	this->variant = variant;
 
 	// Geometry shader is optional, however fragment and vertex are not.
 	if(vertex_source == nullptr || fragment_source == nullptr) {
 		std::cout << "Shader Error: Vertex or fragment source is nullptr.\n";
-		is_ready = false;
 		return;
 	}
 
-	// Compile and check vertex shader.
-	vertex_id = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertex_id, 1, &vertex_source, NULL);
-	glCompileShader(vertex_id);
-	glGetShaderiv(vertex_id, GL_COMPILE_STATUS, &result);
+	// Kept alive until the stages are submitted.
+	std::string vertex_variant = AddVariantDefines(vertex_source, variant);
+	std::string fragment_variant = AddVariantDefines(fragment_source, variant);
+	std::string geometry_variant = (geometry_source != nullptr) ? AddVariantDefines(geometry_source, variant) : std::string();
 
-	if(result != GL_TRUE) {
-		glGetShaderInfoLog(vertex_id, 1024, NULL, result_log);
-		std::cout << "Shader Compile Error: " << result_log << '\n';
-		is_ready = false;
-		return;
+	vertex_source = vertex_variant.c_str();
+	fragment_source = fragment_variant.c_str();
+
+	if(geometry_source != nullptr) {
+		geometry_source = geometry_variant.c_str();
 	}
 
-	// Compile and check fragment shader.
-	fragment_id = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragment_id, 1, &fragment_source, NULL);
-	glCompileShader(fragment_id);
-	glGetShaderiv(fragment_id, GL_COMPILE_STATUS, &result);
+	// Submit every stage and the link up front, status is only checked in FinishCompile
+	// so the driver can compile them in parallel.
+	stage_ids[0] = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(stage_ids[0], 1, &vertex_source, NULL);
+	glCompileShader(stage_ids[0]);
 
-	if(result != GL_TRUE) {
-		glGetShaderInfoLog(fragment_id, 1024, NULL, result_log);
-		std::cout << "Shader Compile Error: " << result_log << '\n';
-		is_ready = false;
-		return;
-	}
+	stage_ids[1] = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(stage_ids[1], 1, &fragment_source, NULL);
+	glCompileShader(stage_ids[1]);
 
-	// Optionally compile and check geomtery shader.
+	// Optionally compile geomtery shader.
+	stage_ids[2] = 0;
 	if(geometry_source != nullptr) {
-		geometry_id = glCreateShader(GL_GEOMETRY_SHADER);
-		glShaderSource(geometry_id, 1, &geometry_source, NULL);
-		glCompileShader(geometry_id);
-		glGetShaderiv(geometry_id, GL_COMPILE_STATUS, &result);
+		stage_ids[2] = glCreateShader(GL_GEOMETRY_SHADER);
+		glShaderSource(stage_ids[2], 1, &geometry_source, NULL);
+		glCompileShader(stage_ids[2]);
+	}
+
+	program_id = glCreateProgram();
+	glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	for(auto stage_id : stage_ids) {
+		if(stage_id != 0) {
+			glAttachShader(program_id, stage_id);
+		}
+	}
+	glLinkProgram(program_id);
+
+	is_pending = true;
+}
+
+bool Shader::PollCompile() {
+
+	if(is_pending == false) {
+		return true;
+	}
+
+	// Without the extension any status query blocks, so just finish right away.
+	if(HasParallelShaderCompile()) {
+		GLint is_complete = GL_FALSE;
+		glGetProgramiv(program_id, GL_COMPLETION_STATUS_KHR, &is_complete);
+
+		if(is_complete == GL_FALSE) {
+			return false;
+		}
+	}
+
+	FinishCompile();
+
+	return true;
+}
+
+void Shader::FinishCompile() {
+
+	int result = 0;
+	char result_log[1024];
+	bool is_compiled = true;
+
+	is_pending = false;
+
+	// Check every stage.
+	for(auto stage_id : stage_ids) {
+		if(stage_id == 0) {
+			continue;
+		}
+
+		glGetShaderiv(stage_id, GL_COMPILE_STATUS, &result);
 
 		if(result != GL_TRUE) {
-			glGetShaderInfoLog(geometry_id, 1024, NULL, result_log);
+			glGetShaderInfoLog(stage_id, 1024, NULL, result_log);
 			std::cout << "Shader Compile Error: " << result_log << '\n';
-			is_ready = false;
-			return;
+			is_compiled = false;
 		}
 	}
 
-	// Link and check shader program.
-	program_id = glCreateProgram();
-	glAttachShader(program_id, vertex_id);
-	glAttachShader(program_id, fragment_id);
-	if(geometry_source != nullptr) {
-		glAttachShader(program_id, geometry_id);
+	// Check shader program.
+	if(is_compiled) {
+		glGetProgramiv(program_id, GL_LINK_STATUS, &result);
+
+		if(result != GL_TRUE) {
+			glGetProgramInfoLog(program_id, 1024, NULL, result_log);
+			std::cout << "Shader Link Error: " << result_log << '\n';
+			is_compiled = false;
+		}
 	}
-	glLinkProgram(program_id);
-	glGetProgramiv(program_id, GL_LINK_STATUS, &result);
 
-	if(result != GL_TRUE) {
-		glGetProgramInfoLog(program_id, 1024, NULL, result_log);
-		std::cout << "Shader Link Error: " << result_log << '\n';
+	// Cleanup unused.
+	for(auto& stage_id : stage_ids) {
+		if(stage_id != 0) {
+			glDeleteShader(stage_id);
+			stage_id = 0;
+		}
+	}
+
+	// A program that failed to build must not be bound by Use().
+	if(is_compiled == false) {
+		RenderState::DeleteProgram(program_id);
+		program_id = 0;
 		is_ready = false;
 		return;
 	}
 
-	// Cleanup unused.
-	glDeleteShader(vertex_id);
-	glDeleteShader(fragment_id);
-	if(geometry_source != nullptr) {
-		glDeleteShader(geometry_id);
+	Reflect();
+
+	is_ready = true;
+}
+
+bool Shader::LoadBinary(std::uint32_t binary_format, const void* data, std::int32_t length, std::uint32_t variant) {
+
+	int result = 0;
+
+	this->variant = variant;
+
+	program_id = glCreateProgram();
+	glProgramBinary(program_id, binary_format, data, length);
+	glGetProgramiv(program_id, GL_LINK_STATUS, &result);
+
+	// Binaries are rejected after driver updates, the caller falls back to compiling.
+	if(result != GL_TRUE) {
+		RenderState::DeleteProgram(program_id);
+		program_id = 0;
+		is_ready = false;
+		return false;
 	}
 
+	Reflect();
+
 	is_ready = true;
+
+	return true;
+}
+
+bool Shader::GetBinary(std::uint32_t& binary_format, std::vector<std::uint8_t>& data) {
+
+	if(is_ready == false) {
+		return false;
+	}
+
+	GLint length = 0;
+	glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	if(length <= 0) {
+		return false;
+	}
+
+	GLenum format = 0;
+	data.resize(length);
+	glGetProgramBinary(program_id, length, NULL, &format, data.data());
+
+	binary_format = format;
+
+	return true;
+}
+
+void Shader::Reflect() {
+
+	reflection = std::make_shared<Reflection>();
+
+	GLint uniform_count = 0;
+	GLint uniform_block_count = 0;
+
+	glGetProgramInterfaceiv(program_id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniform_count);
+	glGetProgramInterfaceiv(program_id, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &uniform_block_count);
+
+	std::vector<char> name_buffer(256);
+
+	const GLenum uniform_properties[] = { GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE, GL_BLOCK_INDEX };
+
+	for(GLint i = 0; i < uniform_count; i++) {
+
+		GLint values[5];
+		glGetProgramResourceiv(program_id, GL_UNIFORM, i, 5, uniform_properties, 5, NULL, values);
+
+		// Members of uniform blocks have no location of their own.
+		if(values[4] != -1) {
+			continue;
+		}
+
+		if(static_cast<size_t>(values[0]) > name_buffer.size()) {
+			name_buffer.resize(values[0]);
+		}
+
+		glGetProgramResourceName(program_id, GL_UNIFORM, i, static_cast<GLsizei>(name_buffer.size()), NULL, name_buffer.data());
+
+		ShaderUniformInfo uniform;
+		uniform.name = name_buffer.data();
+		uniform.type = values[1];
+		uniform.location = values[2];
+		uniform.array_size = values[3];
+		uniform.has_shadow_value = false;
+
+		std::int32_t index = static_cast<std::int32_t>(reflection->uniforms.size());
+		reflection->uniform_indices[uniform.name] = index;
+
+		// Arrays are reported as "name[0]", also allow looking them up by "name".
+		size_t bracket = uniform.name.find("[0]");
+		if(bracket != std::string::npos) {
+			reflection->uniform_indices[uniform.name.substr(0, bracket)] = index;
+		}
+
+		reflection->uniforms.push_back(uniform);
+	}
+
+	const GLenum block_properties[] = { GL_NAME_LENGTH, GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+
+	for(GLint i = 0; i < uniform_block_count; i++) {
+
+		GLint values[3];
+		glGetProgramResourceiv(program_id, GL_UNIFORM_BLOCK, i, 3, block_properties, 3, NULL, values);
+
+		if(static_cast<size_t>(values[0]) > name_buffer.size()) {
+			name_buffer.resize(values[0]);
+		}
+
+		glGetProgramResourceName(program_id, GL_UNIFORM_BLOCK, i, static_cast<GLsizei>(name_buffer.size()), NULL, name_buffer.data());
+
+		ShaderUniformBlockInfo uniform_block;
+		uniform_block.name = name_buffer.data();
+		uniform_block.index = static_cast<std::uint32_t>(i);
+		uniform_block.binding = values[1];
+		uniform_block.data_size = values[2];
+
+		reflection->uniform_blocks.push_back(uniform_block);
+	}
+}
+
+std::int32_t Shader::FindUniform(const char* name, std::uint32_t expected_type) {
+
+	if(reflection == nullptr) {
+		return -1;
+	}
+
+	auto found = reflection->uniform_indices.find(name);
+
+	if(found == reflection->uniform_indices.end()) {
+		return -1;
+	}
+
+	std::uint32_t type = reflection->uniforms[found->second].type;
+
+	// Samplers and bools are set through the int setter.
+	bool is_int_compatible = (type == GL_BOOL || (type >= GL_SAMPLER_1D && type <= GL_SAMPLER_2D_SHADOW) ||
+							  (type >= GL_SAMPLER_1D_ARRAY && type <= GL_UNSIGNED_INT_SAMPLER_BUFFER && (type < GL_UNSIGNED_INT_VEC2 || type > GL_UNSIGNED_INT_VEC4)) ||
+							  (type >= GL_SAMPLER_2D_RECT && type <= GL_SAMPLER_2D_RECT_SHADOW));
+
+	if(expected_type != 0 && type != expected_type && (expected_type != GL_INT || is_int_compatible == false)) {
+		std::cout << "Shader: Uniform \"" << name << "\" type mismatch.\n";
+	}
+
+	return found->second;
+}
+
+bool Shader::UpdateShadowValue(std::int32_t index, const void* value, size_t size) {
+
+	if(index < 0 || reflection == nullptr) {
+		return false;
+	}
+
+	ShaderUniformInfo& uniform = reflection->uniforms[index];
+
+	if(uniform.has_shadow_value && std::memcmp(uniform.shadow_value, value, size) == 0) {
+		return false;
+	}
+
+	std::memcpy(uniform.shadow_value, value, size);
+	uniform.has_shadow_value = true;
+
+	return true;
+}
+
+std::int32_t Shader::GetUniformLocation(const char* name) {
+
+	std::int32_t index = FindUniform(name, 0);
+
+	if(index < 0) {
+		return -1;
+	}
+
+	return reflection->uniforms[index].location;
+}
+
+const ShaderUniformBlockInfo* Shader::GetUniformBlock(const char* name) {
+
+	if(reflection == nullptr) {
+		return nullptr;
+	}
+
+	for(auto& uniform_block : reflection->uniform_blocks) {
+		if(uniform_block.name == name) {
+			return &uniform_block;
+		}
+	}
+
+	return nullptr;
+}
+
+template<> ShaderUniform<int> Shader::GetUniform<int>(const char* name) {
+	return ShaderUniform<int>(FindUniform(name, GL_INT));
+}
+
+template<> ShaderUniform<unsigned int> Shader::GetUniform<unsigned int>(const char* name) {
+	return ShaderUniform<unsigned int>(FindUniform(name, GL_UNSIGNED_INT));
+}
+
+template<> ShaderUniform<float> Shader::GetUniform<float>(const char* name) {
+	return ShaderUniform<float>(FindUniform(name, GL_FLOAT));
+}
+
+template<> ShaderUniform<glm::vec2> Shader::GetUniform<glm::vec2>(const char* name) {
+	return ShaderUniform<glm::vec2>(FindUniform(name, GL_FLOAT_VEC2));
+}
+
+template<> ShaderUniform<glm::vec3> Shader::GetUniform<glm::vec3>(const char* name) {
+	return ShaderUniform<glm::vec3>(FindUniform(name, GL_FLOAT_VEC3));
+}
+
+template<> ShaderUniform<glm::vec4> Shader::GetUniform<glm::vec4>(const char* name) {
+	return ShaderUniform<glm::vec4>(FindUniform(name, GL_FLOAT_VEC4));
+}
+
+template<> ShaderUniform<glm::mat4> Shader::GetUniform<glm::mat4>(const char* name) {
+	return ShaderUniform<glm::mat4>(FindUniform(name, GL_FLOAT_MAT4));
+}
+
+void Shader::Set(ShaderUniform<int> uniform, int value) {
+	if(UpdateShadowValue(uniform.GetIndex(), &value, sizeof(value))) {
+		glProgramUniform1i(program_id, reflection->uniforms[uniform.GetIndex()].location, value);
+	}
+}
+
+void Shader::Set(ShaderUniform<unsigned int> uniform, unsigned int value) {
+	if(UpdateShadowValue(uniform.GetIndex(), &value, sizeof(value))) {
+		glProgramUniform1ui(program_id, reflection->uniforms[uniform.GetIndex()].location, value);
+	}
+}
+
+void Shader::Set(ShaderUniform<float> uniform, float value) {
+	if(UpdateShadowValue(uniform.GetIndex(), &value, sizeof(value))) {
+		glProgramUniform1f(program_id, reflection->uniforms[uniform.GetIndex()].location, value);
+	}
+}
+
+void Shader::Set(ShaderUniform<glm::vec2> uniform, const glm::vec2& value) {
+	if(UpdateShadowValue(uniform.GetIndex(), glm::value_ptr(value), sizeof(float) * 2)) {
+		glProgramUniform2f(program_id, reflection->uniforms[uniform.GetIndex()].location, value.x, value.y);
+	}
+}
+
+void Shader::Set(ShaderUniform<glm::vec3> uniform, const glm::vec3& value) {
+	if(UpdateShadowValue(uniform.GetIndex(), glm::value_ptr(value), sizeof(float) * 3)) {
+		glProgramUniform3f(program_id, reflection->uniforms[uniform.GetIndex()].location, value.x, value.y, value.z);
+	}
+}
+
+void Shader::Set(ShaderUniform<glm::vec4> uniform, const glm::vec4& value) {
+	if(UpdateShadowValue(uniform.GetIndex(), glm::value_ptr(value), sizeof(float) * 4)) {
+		glProgramUniform4f(program_id, reflection->uniforms[uniform.GetIndex()].location, value.x, value.y, value.z, value.w);
+	}
+}
+
+void Shader::Set(ShaderUniform<glm::mat4> uniform, const glm::mat4& value) {
+	if(UpdateShadowValue(uniform.GetIndex(), glm::value_ptr(value), sizeof(float) * 16)) {
+		glProgramUniformMatrix4fv(program_id, reflection->uniforms[uniform.GetIndex()].location, 1, false, glm::value_ptr(value));
+	}
 }
 
 void Shader::Delete() {
 	if(is_ready) {
-		glDeleteProgram(program_id);
+		RenderState::DeleteProgram(program_id);
 	}
 }
 
@@ -124,7 +516,7 @@ void Shader::SetInteger(const char* name, int value, bool use_shader) {
 		Use();
 	}
 
-	glUniform1i(glGetUniformLocation(program_id, name), value);
+	Set(GetUniform<int>(name), value);
 }
 
 void Shader::SetIntegerUnsigned(const char* name, unsigned int value, bool use_shader) {
@@ -133,7 +525,7 @@ void Shader::SetIntegerUnsigned(const char* name, unsigned int value, bool use_s
 		Use();
 	}
 
-	glUniform1ui(glGetUniformLocation(program_id, name), value);
+	Set(GetUniform<unsigned int>(name), value);
 }
 
 void Shader::SetFloat(const char* name, float value, bool use_shader) {
@@ -142,7 +534,7 @@ void Shader::SetFloat(const char* name, float value, bool use_shader) {
 		Use();
 	}
 
-	glUniform1f(glGetUniformLocation(program_id, name), value);
+	Set(GetUniform<float>(name), value);
 }
 
 void Shader::SetVector2f(const char* name, float x, float y, bool use_shader) {
@@ -151,7 +543,7 @@ void Shader::SetVector2f(const char* name, float x, float y, bool use_shader) {
 		Use();
 	}
 
-	glUniform2f(glGetUniformLocation(program_id, name), x, y);
+	Set(GetUniform<glm::vec2>(name), glm::vec2(x, y));
 }
 
 void Shader::SetVector3f(const char* name, float x, float y, float z, bool use_shader) {
@@ -160,7 +552,7 @@ void Shader::SetVector3f(const char* name, float x, float y, float z, bool use_s
 		Use();
 	}
 
-	glUniform3f(glGetUniformLocation(program_id, name), x, y, z);
+	Set(GetUniform<glm::vec3>(name), glm::vec3(x, y, z));
 }
 
 void Shader::SetVector4f(const char* name, float x, float y, float z, float w, bool use_shader) {
@@ -169,7 +561,7 @@ void Shader::SetVector4f(const char* name, float x, float y, float z, float w, b
 		Use();
 	}
 
-	glUniform4f(glGetUniformLocation(program_id, name), x, y, z, w);
+	Set(GetUniform<glm::vec4>(name), glm::vec4(x, y, z, w));
 }
 
 void Shader::SetVector2f(const char* name, const glm::vec2& value, bool use_shader) {
@@ -178,7 +570,7 @@ void Shader::SetVector2f(const char* name, const glm::vec2& value, bool use_shad
 		Use();
 	}
 
-	glUniform2f(glGetUniformLocation(program_id, name), value.x, value.y);
+	Set(GetUniform<glm::vec2>(name), value);
 }
 
 void Shader::SetVector3f(const char* name, const glm::vec3& value, bool use_shader) {
@@ -187,7 +579,7 @@ void Shader::SetVector3f(const char* name, const glm::vec3& value, bool use_shad
 		Use();
 	}
 
-	glUniform3f(glGetUniformLocation(program_id, name), value.x, value.y, value.z);
+	Set(GetUniform<glm::vec3>(name), value);
 }
 
 void Shader::SetVector4f(const char* name, const glm::vec4& value, bool use_shader) {
@@ -196,7 +588,7 @@ void Shader::SetVector4f(const char* name, const glm::vec4& value, bool use_shad
 		Use();
 	}
 
-	glUniform4f(glGetUniformLocation(program_id, name), value.x, value.y, value.z, value.w);
+	Set(GetUniform<glm::vec4>(name), value);
 }
 
 void Shader::SetMatrix4f(const char* name, const glm::mat4& value, bool use_shader) {
@@ -205,5 +597,5 @@ void Shader::SetMatrix4f(const char* name, const glm::mat4& value, bool use_shad
 		Use();
 	}
 
-	glUniformMatrix4fv(glGetUniformLocation(program_id, name), 1, false, glm::value_ptr(value));
+	Set(GetUniform<glm::mat4>(name), value);
 }
\ No newline at end of file
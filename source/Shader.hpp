@@ -20,6 +20,10 @@
 
 // STL
 #include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 // GLAD2
 #include <glad/gl.h>
@@ -28,6 +32,47 @@
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
+// Bits of a shader variant, each set bit is compiled in as a #define of the same name.
+enum ShaderVariantBits : std::uint32_t {
+	SHADER_VARIANT_ALPHA_TEST       = 1 << 0, // Only fully opaque pixels are kept.
+	SHADER_VARIANT_TRANSLUCENT_ONLY = 1 << 1  // Only partially transparent pixels are kept.
+};
+
+// Active uniform read back from the linked program.
+struct ShaderUniformInfo {
+	std::string name;
+	std::int32_t location;
+	std::uint32_t type;
+	std::int32_t array_size;
+
+	// Last value written, used to skip redundant uploads. Large enough for a mat4.
+	std::uint8_t shadow_value[64];
+	bool has_shadow_value;
+};
+
+// Active uniform block read back from the linked program.
+struct ShaderUniformBlockInfo {
+	std::string name;
+	std::uint32_t index;
+	std::int32_t binding;
+	std::int32_t data_size;
+};
+
+// Typed handle to a uniform, resolved once with Shader::GetUniform and reused every draw.
+template<typename T>
+class ShaderUniform {
+
+	public:
+		ShaderUniform() : index(-1) { }
+		explicit ShaderUniform(std::int32_t index) : index(index) { }
+
+		bool IsValid() const { return index >= 0; }
+		std::int32_t GetIndex() const { return index; }
+
+	private:
+		std::int32_t index;
+};
+
 class Shader {
 
 	public:
@@ -35,9 +80,35 @@ class Shader {
 
 		Shader& Use();
 
-		void Compile(const char* vertex_source, const char* fragment_source, const char* geometry_source);
+		// variant is a mask of ShaderVariantBits, their defines are added to every stage.
+		void Compile(const char* vertex_source, const char* fragment_source, const char* geometry_source, std::uint32_t variant = 0);
 		void Delete();
 
+		// Submit all stages and the link without waiting on the driver. Call PollCompile once
+		// per frame until it returns true, the program is usable once IsReady() is true.
+		void CompileAsync(const char* vertex_source, const char* fragment_source, const char* geometry_source, std::uint32_t variant = 0);
+		bool PollCompile();
+
+		// Program binaries, for caching linked programs between runs. LoadBinary returns false if the driver rejects it.
+		bool LoadBinary(std::uint32_t binary_format, const void* data, std::int32_t length, std::uint32_t variant = 0);
+		bool GetBinary(std::uint32_t& binary_format, std::vector<std::uint8_t>& data);
+
+		// Resolve a typed uniform handle. Returns an invalid handle if the uniform isn't active.
+		template<typename T>
+		ShaderUniform<T> GetUniform(const char* name);
+
+		// Typed uniform writes, skipped if the value matches the last one written.
+		void Set(ShaderUniform<int> uniform, int value);
+		void Set(ShaderUniform<unsigned int> uniform, unsigned int value);
+		void Set(ShaderUniform<float> uniform, float value);
+		void Set(ShaderUniform<glm::vec2> uniform, const glm::vec2& value);
+		void Set(ShaderUniform<glm::vec3> uniform, const glm::vec3& value);
+		void Set(ShaderUniform<glm::vec4> uniform, const glm::vec4& value);
+		void Set(ShaderUniform<glm::mat4> uniform, const glm::mat4& value);
+
+		std::int32_t GetUniformLocation(const char* name);
+		const ShaderUniformBlockInfo* GetUniformBlock(const char* name);
+
 		// Raw data types.
 		void SetInteger (const char* name, int value, bool use_shader = false);
 		void SetIntegerUnsigned(const char* name, unsigned int value, bool use_shader = false);
@@ -52,12 +123,46 @@ class Shader {
 		void SetVector4f(const char* name, const glm::vec4& value, bool use_shader = false);
 		void SetMatrix4f(const char* name, const glm::mat4& value, bool use_shader = false);
 
+		// Source with a #define for every bit of variant inserted after the #version line.
+		static std::string AddVariantDefines(const std::string& source, std::uint32_t variant);
+
 		std::uint64_t GetID() { return program_id; }
+		std::uint32_t GetVariant() { return variant; }
+		bool IsReady() { return is_ready; }
+		bool IsPending() { return is_pending; }
 
 	private:
+		// Shared between copies of the same Shader, so shadowed values stay in sync.
+		struct Reflection {
+			std::vector<ShaderUniformInfo> uniforms;
+			std::unordered_map<std::string, std::int32_t> uniform_indices;
+			std::vector<ShaderUniformBlockInfo> uniform_blocks;
+		};
+
 		std::uint64_t program_id;
+		std::uint32_t variant = 0;
+
+		std::shared_ptr<Reflection> reflection;
+
+		// Vertex, fragment and geometry stages while a compile is pending.
+		std::uint32_t stage_ids[3] = { 0, 0, 0 };
 
 		bool is_ready = false;
+		bool is_pending = false;
+
+		void FinishCompile();
+		void Reflect();
+
+		std::int32_t FindUniform(const char* name, std::uint32_t expected_type);
+		bool UpdateShadowValue(std::int32_t index, const void* value, size_t size);
 };
 
+template<> ShaderUniform<int>          Shader::GetUniform<int>(const char* name);
+template<> ShaderUniform<unsigned int> Shader::GetUniform<unsigned int>(const char* name);
+template<> ShaderUniform<float>        Shader::GetUniform<float>(const char* name);
+template<> ShaderUniform<glm::vec2>    Shader::GetUniform<glm::vec2>(const char* name);
+template<> ShaderUniform<glm::vec3>    Shader::GetUniform<glm::vec3>(const char* name);
+template<> ShaderUniform<glm::vec4>    Shader::GetUniform<glm::vec4>(const char* name);
+template<> ShaderUniform<glm::mat4>    Shader::GetUniform<glm::mat4>(const char* name);
+
 #endif /* __SHADER_HPP__ */
\ No newline at end of file
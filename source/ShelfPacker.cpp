@@ -0,0 +1,52 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ShelfPacker.hpp"
+
+ShelfPacker::ShelfPacker(std::uint32_t width, std::uint32_t height, std::uint32_t padding) : area_width(width), area_height(height), padding(padding),
+																							 shelf_x(padding), shelf_y(padding), shelf_height(0) {
+
+}
+
+bool ShelfPacker::Pack(std::uint32_t width, std::uint32_t height, std::uint32_t& x, std::uint32_t& y) {
+
+	if(width + (padding * 2) > area_width) {
+		return false;
+	}
+
+	// Start a new shelf when the current one is full.
+	if(shelf_x + width + padding > area_width) {
+		shelf_x = padding;
+		shelf_y += shelf_height + padding;
+		shelf_height = 0;
+	}
+
+	if(shelf_y + height + padding > area_height) {
+		return false;
+	}
+
+	x = shelf_x;
+	y = shelf_y;
+
+	shelf_x += width + padding;
+
+	if(height > shelf_height) {
+		shelf_height = height;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SHELF_PACKER_HPP__
+#define __SHELF_PACKER_HPP__
+
+// STL
+#include <cstdint>
+
+/**
+ * Places rectangles left to right on horizontal shelves inside a fixed area.
+ *
+ * A new shelf is opened below the tallest rectangle of the current one once a
+ * rectangle no longer fits beside it. Padding is kept free between rectangles
+ * and along the edges of the area.
+ */
+class ShelfPacker {
+
+	public:
+		// Padding is the number of pixels left empty, one keeps glyphs from bleeding into each other.
+		ShelfPacker(std::uint32_t width = 0, std::uint32_t height = 0, std::uint32_t padding = 1);
+
+		// Returns false when the rectangle doesn't fit into what's left of the area.
+		bool Pack(std::uint32_t width, std::uint32_t height, std::uint32_t& x, std::uint32_t& y);
+
+	private:
+		std::uint32_t area_width, area_height;
+		std::uint32_t padding;
+
+		std::uint32_t shelf_x, shelf_y, shelf_height;
+};
+
+#endif /* __SHELF_PACKER_HPP__ */
\ No newline at end of file
@@ -16,7 +16,11 @@
  */
 
 // STL
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
+#include <vector>
 
 // GLAD2
 #include <glad/gl.h>
@@ -25,22 +29,41 @@
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
+#include "RenderState.hpp"
 #include "Shader.hpp"
+#include "StreamBuffer.hpp"
 
 #include "SpriteRenderer.hpp"
 
-SpriteRenderer::SpriteRenderer(Shader& shader) : shader(shader) {
+SpriteRenderer::SpriteRenderer(Shader& shader) : shader(shader), batch_vao(0), batch_vbo(0), batch_ebo(0), batch_capacity(0), stream_buffer(nullptr),
+												   batch_sprite_count(0), batch_draw_calls(0), has_batch_shader(false), is_batching(false) {
+	uniform_model        = this->shader.GetUniform<glm::mat4>("model");
+	uniform_sprite_color = this->shader.GetUniform<glm::vec3>("spriteColor");
+
 	InitRenderData();
 }
 
-SpriteRenderer::~SpriteRenderer() {
-	glDeleteVertexArrays(1, &quad_vao);
-	glDeleteBuffers(1, &quad_vbo);
+SpriteRenderer::SpriteRenderer(Shader& shader, Shader& batch_shader) : shader(shader), batch_shader(batch_shader), batch_vao(0), batch_vbo(0), batch_ebo(0), batch_capacity(0), stream_buffer(nullptr),
+																	   batch_sprite_count(0), batch_draw_calls(0), has_batch_shader(true), is_batching(false) {
+	uniform_model        = this->shader.GetUniform<glm::mat4>("model");
+	uniform_sprite_color = this->shader.GetUniform<glm::vec3>("spriteColor");
+
+	InitRenderData();
+	InitBatchRenderData();
 }
 
-void SpriteRenderer::DrawSprite(Texture2D& texture, glm::vec2 position, glm::vec2 size, float rotation, glm::vec3 color) {
+SpriteRenderer::~SpriteRenderer() {
+	RenderState::DeleteVertexArray(quad_vao);
+	RenderState::DeleteBuffer(quad_vbo);
 
-	shader.Use();
+	if(has_batch_shader) {
+		RenderState::DeleteVertexArray(batch_vao);
+		RenderState::DeleteBuffer(batch_vbo);
+		RenderState::DeleteBuffer(batch_ebo);
+	}
+}
+
+void SpriteRenderer::DrawSprite(Texture2D& texture, glm::vec2 position, glm::vec2 size, float rotation, glm::vec3 color, std::int32_t sort_layer) {
 
 	// If size is set to zero, draw sprite one to one with actual pixel width and height.
 	if(size.x == 0) {
@@ -59,6 +82,13 @@ void SpriteRenderer::DrawSprite(Texture2D& texture, glm::vec2 position, glm::vec
 		return;
 	}
 
+	if(is_batching) {
+		batch_queue.push_back({ position, size, glm::vec2(0.0f), glm::vec2(1.0f), rotation, color, texture.GetID(), sort_layer });
+		return;
+	}
+
+	shader.Use();
+
 	// Prepare transformations.
 	glm::mat4 model = glm::mat4(1.0f);
 	model = glm::translate(model, glm::vec3(position, 0.0f));
@@ -69,13 +99,13 @@ void SpriteRenderer::DrawSprite(Texture2D& texture, glm::vec2 position, glm::vec
 
 	model = glm::scale(model, glm::vec3(size, 1.0f));
 
-	shader.SetMatrix4f("model", model);
-	shader.SetVector3f("spriteColor", color);
+	shader.Set(uniform_model, model);
+	shader.Set(uniform_sprite_color, color);
 
 	texture.Bind();
 
 	// Draw the QuadVAO and then bind nothing.
-	glBindVertexArray(quad_vao);
+	RenderState::BindVertexArray(quad_vao);
 	glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
@@ -104,4 +134,203 @@ void SpriteRenderer::InitRenderData() {
 	glVertexArrayAttribFormat(quad_vao, 0, 4, GL_FLOAT, GL_FALSE, 0);
 
 	glVertexArrayAttribBinding(quad_vao, 0, 0);
+}
+
+void SpriteRenderer::DrawSpriteRegion(Texture2D& texture, glm::vec2 position, glm::vec2 size, glm::vec2 uv_min, glm::vec2 uv_max, glm::vec3 color, std::int32_t sort_layer) {
+
+	if(texture.IsLoaded() == false || texture.IsArrayTexture()) {
+		return;
+	}
+
+	if(has_batch_shader == false) {
+		std::cout << "SpriteRenderer: DrawSpriteRegion requires a batch shader.\n";
+		return;
+	}
+
+	batch_queue.push_back({ position, size, uv_min, uv_max, 0.0f, color, texture.GetID(), sort_layer });
+
+	// In immediate mode draw it right away as a batch of one.
+	if(is_batching == false) {
+		is_batching = true;
+		Flush();
+		is_batching = false;
+	}
+}
+
+void SpriteRenderer::SetBatching(bool enabled) {
+
+	if(enabled && has_batch_shader == false) {
+		std::cout << "SpriteRenderer: Tried to enable batching without a batch shader.\n";
+		return;
+	}
+
+	// Don't lose anything queued before switching to immediate mode.
+	if(enabled == false) {
+		Flush();
+	}
+
+	is_batching = enabled;
+}
+
+void SpriteRenderer::Flush() {
+
+	if(is_batching == false) {
+		return;
+	}
+
+	batch_sprite_count = static_cast<std::uint32_t>(batch_queue.size());
+	batch_draw_calls = 0;
+
+	if(batch_queue.empty()) {
+		return;
+	}
+
+	// Stable sort keeps submission order within the same layer and texture.
+	batch_order.resize(batch_queue.size());
+
+	for(std::uint32_t i = 0; i < batch_order.size(); i++) {
+		batch_order[i] = i;
+	}
+
+	std::stable_sort(batch_order.begin(), batch_order.end(), [this](std::uint32_t a, std::uint32_t b) {
+		const QueuedSprite& sprite_a = batch_queue[a];
+		const QueuedSprite& sprite_b = batch_queue[b];
+
+		if(sprite_a.sort_layer != sprite_b.sort_layer) {
+			return sprite_a.sort_layer < sprite_b.sort_layer;
+		}
+
+		return sprite_a.texture_id < sprite_b.texture_id;
+	});
+
+	ReserveBatchCapacity(static_cast<std::uint32_t>(batch_queue.size()));
+
+	// Prefer writing straight into mapped memory, fall back to a CPU copy and re-upload.
+	std::uint32_t vertex_bytes = static_cast<std::uint32_t>(batch_queue.size() * 4 * sizeof(SpriteVertex));
+	std::uint32_t stream_offset = 0;
+	SpriteVertex* vertices = nullptr;
+
+	if(stream_buffer != nullptr) {
+		vertices = static_cast<SpriteVertex*>(stream_buffer->Allocate(vertex_bytes, sizeof(float), stream_offset));
+	}
+
+	bool is_streamed = (vertices != nullptr);
+
+	if(is_streamed == false) {
+		batch_vertices.resize(batch_queue.size() * 4);
+		vertices = batch_vertices.data();
+	}
+
+	// Build the quads, rotated around their center like the immediate path.
+
+	const glm::vec2 corners[4] = { glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 1.0f) };
+
+	for(size_t i = 0; i < batch_order.size(); i++) {
+
+		const QueuedSprite& sprite = batch_queue[batch_order[i]];
+
+		float radians = glm::radians(sprite.rotation);
+		float cos_r = std::cos(radians);
+		float sin_r = std::sin(radians);
+
+		glm::vec2 center = sprite.position + (0.5f * sprite.size);
+
+		for(int c = 0; c < 4; c++) {
+			glm::vec2 local = (corners[c] - glm::vec2(0.5f)) * sprite.size;
+
+			SpriteVertex& vertex = vertices[(i * 4) + c];
+			vertex.x = center.x + (local.x * cos_r) - (local.y * sin_r);
+			vertex.y = center.y + (local.x * sin_r) + (local.y * cos_r);
+			vertex.u = sprite.uv_min.x + (corners[c].x * (sprite.uv_max.x - sprite.uv_min.x));
+			vertex.v = sprite.uv_min.y + (corners[c].y * (sprite.uv_max.y - sprite.uv_min.y));
+			vertex.r = sprite.color.x;
+			vertex.g = sprite.color.y;
+			vertex.b = sprite.color.z;
+		}
+	}
+
+	if(is_streamed) {
+		glVertexArrayVertexBuffer(batch_vao, 0, stream_buffer->GetID(), stream_offset, sizeof(SpriteVertex));
+	} else {
+		// Orphan the previous contents so the driver doesn't wait on the last frame's draws.
+		glNamedBufferData(batch_vbo, batch_capacity * 4 * sizeof(SpriteVertex), nullptr, GL_STREAM_DRAW);
+		glNamedBufferSubData(batch_vbo, 0, vertex_bytes, vertices);
+		glVertexArrayVertexBuffer(batch_vao, 0, batch_vbo, 0, sizeof(SpriteVertex));
+	}
+
+	batch_shader.Use();
+	RenderState::BindVertexArray(batch_vao);
+
+	// One draw per run of sprites sharing a texture.
+	size_t run_start = 0;
+
+	while(run_start < batch_order.size()) {
+
+		std::uint32_t texture_id = batch_queue[batch_order[run_start]].texture_id;
+		size_t run_end = run_start + 1;
+
+		while(run_end < batch_order.size() && batch_queue[batch_order[run_end]].texture_id == texture_id) {
+			run_end++;
+		}
+
+		RenderState::BindTexture(0, texture_id);
+		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>((run_end - run_start) * 6), GL_UNSIGNED_INT, reinterpret_cast<void*>(run_start * 6 * sizeof(std::uint32_t)));
+
+		batch_draw_calls++;
+		run_start = run_end;
+	}
+
+	batch_queue.clear();
+}
+
+void SpriteRenderer::ReserveBatchCapacity(std::uint32_t sprite_count) {
+
+	if(sprite_count <= batch_capacity) {
+		return;
+	}
+
+	// Grow in powers of two to avoid reallocating every frame.
+	std::uint32_t new_capacity = std::max<std::uint32_t>(batch_capacity, 64);
+
+	while(new_capacity < sprite_count) {
+		new_capacity *= 2;
+	}
+
+	std::vector<std::uint32_t> indices(new_capacity * 6);
+
+	for(std::uint32_t i = 0; i < new_capacity; i++) {
+		indices[(i * 6) + 0] = (i * 4) + 0;
+		indices[(i * 6) + 1] = (i * 4) + 1;
+		indices[(i * 6) + 2] = (i * 4) + 2;
+		indices[(i * 6) + 3] = (i * 4) + 2;
+		indices[(i * 6) + 4] = (i * 4) + 3;
+		indices[(i * 6) + 5] = (i * 4) + 0;
+	}
+
+	glNamedBufferData(batch_ebo, indices.size() * sizeof(std::uint32_t), indices.data(), GL_STATIC_DRAW);
+
+	batch_capacity = new_capacity;
+}
+
+void SpriteRenderer::InitBatchRenderData() {
+
+	glCreateBuffers(1, &batch_vbo);
+	glCreateBuffers(1, &batch_ebo);
+
+	glCreateVertexArrays(1, &batch_vao);
+
+	glVertexArrayVertexBuffer(batch_vao, 0, batch_vbo, 0, sizeof(SpriteVertex));
+	glVertexArrayElementBuffer(batch_vao, batch_ebo);
+
+	// Position and texture coordinates.
+	glEnableVertexArrayAttrib(batch_vao, 0);
+	glVertexArrayAttribFormat(batch_vao, 0, 4, GL_FLOAT, GL_FALSE, offsetof(SpriteVertex, x));
+	glVertexArrayAttribBinding(batch_vao, 0, 0);
+
+	// Color.
+	glEnableVertexArrayAttrib(batch_vao, 1);
+	glVertexArrayAttribFormat(batch_vao, 1, 3, GL_FLOAT, GL_FALSE, offsetof(SpriteVertex, r));
+	glVertexArrayAttribBinding(batch_vao, 1, 0);
+
+	ReserveBatchCapacity(64);
 }
\ No newline at end of file
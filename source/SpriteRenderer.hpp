@@ -20,28 +20,100 @@
 
 // STL
 #include <cstdint>
+#include <vector>
 
 // GLM
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
 #include "Shader.hpp"
+#include "StreamBuffer.hpp"
 #include "Texture2D.hpp"
 
+/**
+ * Draws textured quads, either immediately or batched.
+ *
+ * In batched mode DrawSprite only queues the sprite. Flush() sorts the queue by
+ * sort_layer and then by texture, builds one vertex buffer and issues a single draw
+ * per run of sprites sharing a texture. The sort is stable, so sprites on the same
+ * sort_layer and texture keep their submission order. Painter's order is only kept
+ * between different sort_layers, overlapping sprites with different textures must
+ * be given different sort_layers if their order matters.
+ */
 class SpriteRenderer {
 
 	public:
 		SpriteRenderer(Shader& shader);
+		SpriteRenderer(Shader& shader, Shader& batch_shader);
 		~SpriteRenderer();
 
-		void DrawSprite(Texture2D& texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f), float rotation = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+		void DrawSprite(Texture2D& texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f), float rotation = 0.0f, glm::vec3 color = glm::vec3(1.0f), std::int32_t sort_layer = 0);
+
+		// Draw a sub-rectangle of a texture (in texture coordinates). Always goes through the batch path.
+		void DrawSpriteRegion(Texture2D& texture, glm::vec2 position, glm::vec2 size, glm::vec2 uv_min, glm::vec2 uv_max, glm::vec3 color = glm::vec3(1.0f), std::int32_t sort_layer = 0);
+
+		// Draw everything queued since the last flush. Does nothing in immediate mode.
+		void Flush();
+
+		void SetBatching(bool enabled);
+		bool IsBatching() { return is_batching; }
+
+		// Write batched vertices straight into a persistently mapped StreamBuffer instead of re-uploading.
+		void SetStreamBuffer(StreamBuffer* stream_buffer) { this->stream_buffer = stream_buffer; }
+
+		// The program the next sprite is drawn with.
+		std::uint32_t GetShaderID() { return static_cast<std::uint32_t>(is_batching ? batch_shader.GetID() : shader.GetID()); }
+
+		std::uint32_t GetBatchSpriteCount() { return batch_sprite_count; }
+		std::uint32_t GetBatchDrawCalls()   { return batch_draw_calls; }
 
 	private:
+		struct QueuedSprite {
+			glm::vec2 position;
+			glm::vec2 size;
+			glm::vec2 uv_min;
+			glm::vec2 uv_max;
+			float rotation;
+			glm::vec3 color;
+			std::uint32_t texture_id;
+			std::int32_t sort_layer;
+		};
+
+		struct SpriteVertex {
+			float x, y;
+			float u, v;
+			float r, g, b;
+		};
+
 		Shader shader;
+		ShaderUniform<glm::mat4> uniform_model;
+		ShaderUniform<glm::vec3> uniform_sprite_color;
+
 		std::uint32_t quad_vao;
 		std::uint32_t quad_vbo;
 
+		Shader batch_shader;
+		std::uint32_t batch_vao;
+		std::uint32_t batch_vbo;
+		std::uint32_t batch_ebo;
+		std::uint32_t batch_capacity;
+
+		std::vector<QueuedSprite> batch_queue;
+		std::vector<std::uint32_t> batch_order;
+		std::vector<SpriteVertex> batch_vertices;
+
+		StreamBuffer* stream_buffer;
+
+		// Statistics of the last Flush().
+		std::uint32_t batch_sprite_count;
+		std::uint32_t batch_draw_calls;
+
+		bool has_batch_shader;
+		bool is_batching;
+
 		void InitRenderData();
+		void InitBatchRenderData();
+		void ReserveBatchCapacity(std::uint32_t sprite_count);
 };
 
 #endif /* __SPRITE_RENDERER_HPP__ */
\ No newline at end of file
@@ -0,0 +1,133 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <cstdint>
+#include <iostream>
+
+// GLAD2
+#include <glad/gl.h>
+
+// SDL2
+#include "SDL.h"
+
+#include "RenderState.hpp"
+#include "StreamBuffer.hpp"
+
+StreamBuffer::StreamBuffer(std::uint32_t region_size, std::uint32_t region_count) : buffer_id(0), mapped_data(nullptr),
+																					 region_size(region_size), region_count(region_count),
+																					 current_region(0), region_offset(0),
+																					 region_fences(region_count, nullptr),
+																					 frame_bytes_streamed(0), last_frame_bytes_streamed(0),
+																					 frame_fence_wait_time(0.0), last_frame_fence_wait_time(0.0) {
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glCreateBuffers(1, &buffer_id);
+	glNamedBufferStorage(buffer_id, static_cast<GLsizeiptr>(region_size) * region_count, nullptr, flags);
+
+	mapped_data = static_cast<std::uint8_t*>(glMapNamedBufferRange(buffer_id, 0, static_cast<GLsizeiptr>(region_size) * region_count, flags));
+
+	if(mapped_data == nullptr) {
+		std::cout << "StreamBuffer: Failed to persistently map buffer.\n";
+	}
+}
+
+StreamBuffer::~StreamBuffer() {
+
+	for(auto& fence : region_fences) {
+		if(fence != nullptr) {
+			glDeleteSync(fence);
+		}
+	}
+
+	if(mapped_data != nullptr) {
+		glUnmapNamedBuffer(buffer_id);
+	}
+
+	RenderState::DeleteBuffer(buffer_id);
+}
+
+void StreamBuffer::BeginFrame() {
+
+	current_region = (current_region + 1) % region_count;
+	region_offset = 0;
+
+	frame_bytes_streamed = 0;
+	frame_fence_wait_time = 0.0;
+
+	GLsync& fence = region_fences[current_region];
+
+	if(fence == nullptr) {
+		return;
+	}
+
+	// Wait for the GPU to finish reading this region from region_count frames ago.
+	std::uint64_t wait_start = SDL_GetPerformanceCounter();
+	GLenum result = glClientWaitSync(fence, 0, 0);
+
+	while(result == GL_TIMEOUT_EXPIRED) {
+		result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+	}
+
+	if(result == GL_WAIT_FAILED) {
+		std::cout << "StreamBuffer: glClientWaitSync failed.\n";
+	}
+
+	frame_fence_wait_time = (SDL_GetPerformanceCounter() - wait_start) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void StreamBuffer::EndFrame() {
+
+	GLsync& fence = region_fences[current_region];
+
+	if(fence != nullptr) {
+		glDeleteSync(fence);
+	}
+
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	last_frame_bytes_streamed = frame_bytes_streamed;
+	last_frame_fence_wait_time = frame_fence_wait_time;
+}
+
+void* StreamBuffer::Allocate(std::uint32_t size, std::uint32_t alignment, std::uint32_t& offset) {
+
+	if(mapped_data == nullptr) {
+		return nullptr;
+	}
+
+	std::uint32_t aligned_offset = region_offset;
+
+	if(alignment > 1) {
+		aligned_offset = ((region_offset + alignment - 1) / alignment) * alignment;
+	}
+
+	if(aligned_offset + size > region_size) {
+		return nullptr;
+	}
+
+	region_offset = aligned_offset + size;
+	frame_bytes_streamed += size;
+
+	offset = (current_region * region_size) + aligned_offset;
+
+	return mapped_data + offset;
+}
\ No newline at end of file
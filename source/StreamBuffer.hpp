@@ -0,0 +1,75 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __STREAM_BUFFER_HPP__
+#define __STREAM_BUFFER_HPP__
+
+// STL
+#include <cstdint>
+#include <vector>
+
+// GLAD2
+#include <glad/gl.h>
+
+/**
+ * Persistently mapped buffer for per-frame vertex data.
+ *
+ * The buffer is split into region_count regions (three by default), one per frame in
+ * flight. BeginFrame() moves to the next region and waits on the fence placed when
+ * that region was last used, EndFrame() places a new fence. In between, Allocate()
+ * hands out pointers straight into mapped memory.
+ */
+class StreamBuffer {
+
+	public:
+		StreamBuffer(std::uint32_t region_size, std::uint32_t region_count = 3);
+		~StreamBuffer();
+
+		void BeginFrame();
+		void EndFrame();
+
+		// Returns nullptr if the current region has no room left, offset is from the start of the buffer.
+		void* Allocate(std::uint32_t size, std::uint32_t alignment, std::uint32_t& offset);
+
+		std::uint32_t GetID()         { return buffer_id; }
+		std::uint32_t GetRegionSize() { return region_size; }
+		bool          IsMapped()      { return mapped_data != nullptr; }
+
+		// Statistics of the last completed frame.
+		std::uint64_t GetBytesStreamed()  { return last_frame_bytes_streamed; }
+		double        GetFenceWaitTime()  { return last_frame_fence_wait_time; }
+
+	private:
+		std::uint32_t buffer_id;
+		std::uint8_t* mapped_data;
+
+		std::uint32_t region_size;
+		std::uint32_t region_count;
+		std::uint32_t current_region;
+		std::uint32_t region_offset;
+
+		std::vector<GLsync> region_fences;
+
+		std::uint64_t frame_bytes_streamed;
+		std::uint64_t last_frame_bytes_streamed;
+
+		// Milliseconds spent in glClientWaitSync.
+		double frame_fence_wait_time;
+		double last_frame_fence_wait_time;
+};
+
+#endif /* __STREAM_BUFFER_HPP__ */
\ No newline at end of file
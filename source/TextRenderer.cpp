@@ -0,0 +1,238 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// GLAD2
+#include <glad/gl.h>
+
+// SDL2
+#include "SDL.h"
+#include "SDL_ttf.h"
+
+#include "Font.hpp"
+#include "SDFFont.hpp"
+#include "SpriteRenderer.hpp"
+#include "TextRenderer.hpp"
+#include "Texture2D.hpp"
+
+// Decode one UTF-8 sequence, returns its length in bytes. Invalid bytes decode as U+FFFD.
+static size_t DecodeUTF8(const char* text, std::uint32_t& codepoint) {
+
+	const std::uint8_t* bytes = reinterpret_cast<const std::uint8_t*>(text);
+
+	if(bytes[0] < 0x80) {
+		codepoint = bytes[0];
+		return 1;
+	}
+
+	size_t length = 0;
+
+	if((bytes[0] & 0xE0) == 0xC0) {
+		codepoint = bytes[0] & 0x1F;
+		length = 2;
+	} else if((bytes[0] & 0xF0) == 0xE0) {
+		codepoint = bytes[0] & 0x0F;
+		length = 3;
+	} else if((bytes[0] & 0xF8) == 0xF0) {
+		codepoint = bytes[0] & 0x07;
+		length = 4;
+	} else {
+		codepoint = 0xFFFD;
+		return 1;
+	}
+
+	for(size_t i = 1; i < length; i++) {
+		if((bytes[i] & 0xC0) != 0x80) {
+			codepoint = 0xFFFD;
+			return i;
+		}
+		codepoint = (codepoint << 6) | (bytes[i] & 0x3F);
+	}
+
+	return length;
+}
+
+TextRenderer::TextRenderer(SpriteRenderer* sprite_renderer, SpriteRenderer* sdf_renderer, std::uint32_t atlas_size) : sprite_renderer(sprite_renderer), sdf_renderer(sdf_renderer), atlas_size(atlas_size),
+																						  packer(atlas_size, atlas_size) {
+
+	std::vector<std::uint8_t> empty(atlas_size * atlas_size * 4, 0);
+
+	atlas.SetInternalFormat(GL_RGBA8);
+	atlas.SetImageFormat(GL_RGBA);
+	atlas.SetFilterMinMax(GL_NEAREST, GL_NEAREST);
+	atlas.Generate(atlas_size, atlas_size, empty.data());
+}
+
+TextRenderer::~TextRenderer() {
+	atlas.Delete();
+}
+
+void TextRenderer::DrawString(Font& font, const char* text, int position_x, int position_y, glm::vec3 color, std::int32_t sort_layer) {
+
+	if(font.GetFont() == nullptr || text == nullptr) {
+		return;
+	}
+
+	int pen_x = position_x;
+	int pen_y = position_y;
+
+	const char* current = text;
+
+	while(*current != '\0') {
+
+		std::uint32_t codepoint = 0;
+		size_t length = DecodeUTF8(current, codepoint);
+
+		if(codepoint == '\n') {
+			pen_x = position_x;
+			pen_y += TTF_FontLineSkip(font.GetFont());
+			current += length;
+			continue;
+		}
+
+		const Glyph* glyph = GetGlyph(font.GetFont(), codepoint, current, length);
+
+		if(glyph != nullptr) {
+			if(glyph->width != 0 && glyph->height != 0) {
+				sprite_renderer->DrawSpriteRegion(atlas, glm::vec2(pen_x, pen_y), glm::vec2(glyph->width, glyph->height), glyph->uv_min, glyph->uv_max, color, sort_layer);
+			}
+
+			pen_x += glyph->advance;
+		}
+
+		current += length;
+	}
+}
+
+void TextRenderer::DrawString(SDFFont& font, const char* text, float position_x, float position_y, float pixel_size, glm::vec3 color, std::int32_t sort_layer) {
+
+	if(font.IsLoaded() == false || text == nullptr) {
+		return;
+	}
+
+	if(sdf_renderer == nullptr) {
+		std::cout << "TextRenderer: Tried to draw an SDFFont without an SDF renderer.\n";
+		return;
+	}
+
+	float scale = pixel_size / font.GetBaseSize();
+
+	// No rounding here, the field is smooth enough to sit on sub-pixel positions.
+	float pen_x = position_x;
+	float pen_y = position_y;
+
+	const char* current = text;
+
+	while(*current != '\0') {
+
+		std::uint32_t codepoint = 0;
+		size_t length = DecodeUTF8(current, codepoint);
+
+		current += length;
+
+		if(codepoint == '\n') {
+			pen_x = position_x;
+			pen_y += font.GetLineSkip() * scale;
+			continue;
+		}
+
+		const SDFFont::Glyph* glyph = font.GetGlyph(codepoint);
+
+		if(glyph == nullptr) {
+			continue;
+		}
+
+		if(glyph->size.x != 0.0f && glyph->size.y != 0.0f) {
+			sdf_renderer->DrawSpriteRegion(font.GetAtlas(), glm::vec2(pen_x, pen_y) + (glyph->offset * scale), glyph->size * scale, glyph->uv_min, glyph->uv_max, color, sort_layer);
+		}
+
+		pen_x += glyph->advance * scale;
+	}
+}
+
+const TextRenderer::Glyph* TextRenderer::GetGlyph(TTF_Font* font, std::uint32_t codepoint, const char* utf8, size_t utf8_length) {
+
+	auto key = std::make_pair(font, codepoint);
+	auto found = glyphs.find(key);
+
+	if(found != glyphs.end()) {
+		return &found->second;
+	}
+
+	// SDL_ttf glyph functions only take the basic multilingual plane.
+	if(codepoint > 0xFFFF) {
+		return nullptr;
+	}
+
+	Glyph glyph;
+	glyph.uv_min = glm::vec2(0.0f);
+	glyph.uv_max = glm::vec2(0.0f);
+	glyph.width = 0;
+	glyph.height = 0;
+	glyph.advance = 0;
+
+	int min_x, max_x, min_y, max_y;
+
+	if(TTF_GlyphMetrics(font, static_cast<Uint16>(codepoint), &min_x, &max_x, &min_y, &max_y, &glyph.advance) != 0) {
+		glyphs[key] = glyph;
+		return &glyphs[key];
+	}
+
+	// Render the single character as a line so it has the same height and baseline as whole-string rendering.
+	std::string character(utf8, utf8_length);
+	SDL_Color white = { 0xFF, 0xFF, 0xFF, 0xFF };
+
+	SDL_Surface* glyph_surface = TTF_RenderUTF8_Blended(font, character.c_str(), white);
+
+	if(glyph_surface == NULL) {
+		glyphs[key] = glyph;
+		return &glyphs[key];
+	}
+
+	SDL_Surface* rgba_surface = SDL_ConvertSurfaceFormat(glyph_surface, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(glyph_surface);
+
+	if(rgba_surface == NULL) {
+		std::cout << "TextRenderer: Failed to convert glyph surface. SDL_GetError(): " << SDL_GetError() << "\n";
+		glyphs[key] = glyph;
+		return &glyphs[key];
+	}
+
+	std::uint32_t atlas_x = 0;
+	std::uint32_t atlas_y = 0;
+
+	if(packer.Pack(rgba_surface->w, rgba_surface->h, atlas_x, atlas_y)) {
+		atlas.Update(atlas_x, atlas_y, rgba_surface->w, rgba_surface->h, static_cast<std::uint8_t*>(rgba_surface->pixels), rgba_surface->pitch / 4);
+
+		glyph.width = rgba_surface->w;
+		glyph.height = rgba_surface->h;
+		glyph.uv_min = glm::vec2(atlas_x / static_cast<float>(atlas_size), atlas_y / static_cast<float>(atlas_size));
+		glyph.uv_max = glm::vec2((atlas_x + rgba_surface->w) / static_cast<float>(atlas_size), (atlas_y + rgba_surface->h) / static_cast<float>(atlas_size));
+	} else {
+		std::cout << "TextRenderer: Glyph atlas is full.\n";
+	}
+
+	SDL_FreeSurface(rgba_surface);
+
+	glyphs[key] = glyph;
+	return &glyphs[key];
+}
\ No newline at end of file
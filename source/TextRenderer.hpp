@@ -0,0 +1,82 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TEXT_RENDERER_HPP__
+#define __TEXT_RENDERER_HPP__
+
+// STL
+#include <cstdint>
+#include <map>
+#include <utility>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+// SDL2
+#include "SDL_ttf.h"
+
+#include "Font.hpp"
+#include "SDFFont.hpp"
+#include "ShelfPacker.hpp"
+#include "SpriteRenderer.hpp"
+#include "Texture2D.hpp"
+
+/**
+ * Draws text from a glyph atlas shared between all fonts.
+ *
+ * Each glyph of each TTF_Font is rasterized once, in white, into the atlas texture.
+ * Strings are laid out as one quad per glyph and queued on the SpriteRenderer batch,
+ * so all text in a frame is drawn together without creating or uploading textures.
+ *
+ * SDFFonts are drawn at any pixel size from their own distance field atlas. They are
+ * queued on sdf_renderer instead, which must be a batching SpriteRenderer whose batch
+ * shader thresholds the field (sdf_text.frag.glsl).
+ */
+class TextRenderer {
+
+	public:
+		TextRenderer(SpriteRenderer* sprite_renderer, SpriteRenderer* sdf_renderer = nullptr, std::uint32_t atlas_size = 1024);
+		~TextRenderer();
+
+		void DrawString(Font& font, const char* text, int position_x, int position_y, glm::vec3 color = glm::vec3(1.0f), std::int32_t sort_layer = 0);
+		void DrawString(SDFFont& font, const char* text, float position_x, float position_y, float pixel_size, glm::vec3 color = glm::vec3(1.0f), std::int32_t sort_layer = 0);
+
+		std::uint32_t GetGlyphCount() { return static_cast<std::uint32_t>(glyphs.size()); }
+
+	private:
+		struct Glyph {
+			glm::vec2 uv_min;
+			glm::vec2 uv_max;
+			std::uint32_t width, height;
+			int advance;
+		};
+
+		SpriteRenderer* sprite_renderer;
+		SpriteRenderer* sdf_renderer;
+
+		Texture2D atlas;
+		std::uint32_t atlas_size;
+
+		ShelfPacker packer;
+
+		std::map<std::pair<TTF_Font*, std::uint32_t>, Glyph> glyphs;
+
+		const Glyph* GetGlyph(TTF_Font* font, std::uint32_t codepoint, const char* utf8, size_t utf8_length);
+};
+
+#endif /* __TEXT_RENDERER_HPP__ */
\ No newline at end of file
@@ -16,8 +16,20 @@
  */
 
 // STL
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 // GLAD2
 #include <glad/gl.h>
@@ -25,8 +37,118 @@
 // SDL2
 #include "SDL.h"
 
+#include "RenderState.hpp"
 #include "Texture2D.hpp"
 
+// Sheets at least this big are sliced on every hardware thread.
+static const size_t parallel_slice_size = 1024 * 1024;
+
+// Copy one row of pixels, 64 bytes per iteration where SSE2 is available.
+static void CopyRow(std::uint8_t* destination, const std::uint8_t* source, size_t size) {
+
+	size_t offset = 0;
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	for(; offset + 64 <= size; offset += 64) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + offset));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + offset + 16));
+		__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + offset + 32));
+		__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + offset + 48));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + offset), a);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + offset + 16), b);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + offset + 32), c);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + offset + 48), d);
+	}
+
+	for(; offset + 16 <= size; offset += 16) {
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + offset), _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + offset)));
+	}
+#endif
+
+	std::memcpy(destination + offset, source + offset, size - offset);
+}
+
+static void SliceTileRange(const std::uint8_t* sheet, std::uint32_t sheet_width, std::uint32_t tile_width, std::uint32_t tile_height, size_t tiles_x, size_t tile_begin, size_t tile_end, std::uint8_t* layers) {
+
+	size_t row_size = tile_width * 4;
+
+	for(size_t tile = tile_begin; tile < tile_end; tile++) {
+
+		const std::uint8_t* source = sheet + (((((tile / tiles_x) * tile_height) * sheet_width) + ((tile % tiles_x) * tile_width)) * 4);
+		std::uint8_t* destination = layers + (tile * tile_height * row_size);
+
+		for(std::uint32_t row = 0; row < tile_height; row++) {
+			CopyRow(destination, source, row_size);
+			source += sheet_width * 4;
+			destination += row_size;
+		}
+	}
+}
+
+// Classify a region of RGBA8 pixels by its alpha, 8 pixels per iteration with AVX2 or 4 with SSE2.
+static TileOpacity ClassifyRegion(const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height, size_t row_stride) {
+
+	bool is_opaque = true;
+	bool is_empty = true;
+
+	// Once a row proves it's neither the rest can't change that.
+	for(std::uint32_t y = 0; y < height && (is_opaque || is_empty); y++) {
+
+		const std::uint8_t* row = pixels + (y * row_stride);
+		std::uint32_t x = 0;
+
+#if defined(__AVX2__)
+		if(width >= 8) {
+			__m256i alpha_and = _mm256_set1_epi8(-1);
+			__m256i alpha_or = _mm256_setzero_si256();
+
+			for(; x + 8 <= width; x += 8) {
+				__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + (x * 4)));
+				alpha_and = _mm256_and_si256(alpha_and, block);
+				alpha_or = _mm256_or_si256(alpha_or, block);
+			}
+
+			// Only every fourth byte is alpha.
+			std::uint32_t all_set = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(alpha_and, _mm256_set1_epi8(-1))));
+			std::uint32_t all_clear = static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(alpha_or, _mm256_setzero_si256())));
+
+			is_opaque = is_opaque && (all_set & 0x88888888u) == 0x88888888u;
+			is_empty = is_empty && (all_clear & 0x88888888u) == 0x88888888u;
+		}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		if(width >= 4) {
+			__m128i alpha_and = _mm_set1_epi8(-1);
+			__m128i alpha_or = _mm_setzero_si128();
+
+			for(; x + 4 <= width; x += 4) {
+				__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + (x * 4)));
+				alpha_and = _mm_and_si128(alpha_and, block);
+				alpha_or = _mm_or_si128(alpha_or, block);
+			}
+
+			// Only every fourth byte is alpha.
+			std::uint32_t all_set = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(alpha_and, _mm_set1_epi8(-1))));
+			std::uint32_t all_clear = static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(alpha_or, _mm_setzero_si128())));
+
+			is_opaque = is_opaque && (all_set & 0x8888u) == 0x8888u;
+			is_empty = is_empty && (all_clear & 0x8888u) == 0x8888u;
+		}
+#endif
+
+		for(; x < width; x++) {
+			std::uint8_t alpha = row[(x * 4) + 3];
+			is_opaque = is_opaque && alpha == 0xFF;
+			is_empty = is_empty && alpha == 0x00;
+		}
+	}
+
+	if(is_empty) {
+		return TileOpacity::Empty;
+	}
+
+	return is_opaque ? TileOpacity::Opaque : TileOpacity::Partial;
+}
+
 // TODO: Investigate GL_REPEAT for wrap_s
 Texture2D::Texture2D() : texture_id(0), width(0), height(0),
 						 subimage_size_x(0), subimage_size_y(0), subimage_count(0),
@@ -38,6 +160,111 @@ Texture2D::Texture2D() : texture_id(0), width(0), height(0),
 
 void Texture2D::Generate(std::uint32_t width, std::uint32_t height, std::uint8_t* data) {
 
+	Allocate(width, height);
+
+	if(is_loaded) {
+		UploadRows(0, height, data);
+	}
+}
+
+void Texture2D::GenerateArray(std::uint32_t width, std::uint32_t height, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y, std::uint8_t* data, bool use_pixel_buffer) {
+
+	if(is_loaded) {
+		std::cout << "Tried to re-generate a texture." << std::endl;
+		return;
+	}
+
+	size_t tiles_x = width / subimage_size_x;
+	size_t tiles_y = height / subimage_size_y;
+	size_t tile_count = tiles_x * tiles_y;
+
+	// Uncompressed sheets are sliced into layer order on the CPU and uploaded in one call.
+	if(IsCompressed() == false) {
+
+		size_t layers_size = tile_count * subimage_size_x * subimage_size_y * 4;
+
+		SetSubImageOpacity(ClassifyTiles(data, width, height, subimage_size_x, subimage_size_y));
+
+		// Slice straight into a mapped pixel unpack buffer, skipping the staging copy.
+		if(use_pixel_buffer) {
+
+			GLuint pixel_buffer = 0;
+			glCreateBuffers(1, &pixel_buffer);
+			glNamedBufferStorage(pixel_buffer, layers_size, nullptr, GL_MAP_WRITE_BIT);
+
+			std::uint8_t* mapped_layers = static_cast<std::uint8_t*>(glMapNamedBufferRange(pixel_buffer, 0, layers_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+
+			if(mapped_layers != nullptr) {
+				SliceTiles(data, width, height, subimage_size_x, subimage_size_y, mapped_layers);
+				glUnmapNamedBuffer(pixel_buffer);
+
+				// With a pixel unpack buffer bound the data pointer is an offset into it.
+				RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer);
+				GenerateArrayFromLayers(width, height, subimage_size_x, subimage_size_y, tile_count, nullptr);
+				RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+				RenderState::DeleteBuffer(pixel_buffer);
+				return;
+			}
+
+			RenderState::DeleteBuffer(pixel_buffer);
+		}
+
+		std::vector<std::uint8_t> layers(layers_size);
+		SliceTiles(data, width, height, subimage_size_x, subimage_size_y, layers.data());
+		GenerateArrayFromLayers(width, height, subimage_size_x, subimage_size_y, tile_count, layers.data());
+		return;
+	}
+
+	this->width = width;
+	this->height = height;
+	this->subimage_size_x = subimage_size_x;
+	this->subimage_size_y = subimage_size_y;
+	this->subimage_count = tile_count;
+
+	// Create array texture.
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texture_id);
+	glTextureStorage3D(texture_id, 1, format_internal, subimage_size_x, subimage_size_y, tile_count);
+	
+	// Compressed sheets go through a temporary texture and are copied block for block, so tiles must be a multiple of 4 pixels.
+	GLuint temporary_texture = 0;
+	glCreateTextures(GL_TEXTURE_2D, 1, &temporary_texture);
+	glTextureStorage2D(temporary_texture, 1, format_internal, width, height);
+	glCompressedTextureSubImage2D(temporary_texture, 0, 0, 0, width, height, format_internal, GetCompressedImageSize(format_internal, width, height), data);
+
+	// Use helper texture to fill main array texture.
+	for(auto i = 0; i < tile_count; i++) {
+		auto x = (i % tiles_x) * subimage_size_x;
+		auto y = (i / tiles_x) * subimage_size_y;
+		glCopyImageSubData(temporary_texture, GL_TEXTURE_2D, 0, x, y, 0, texture_id, GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, subimage_size_x, subimage_size_y, 1);
+	}
+
+	RenderState::DeleteTexture(temporary_texture);
+
+	// Set texture parameters.
+	glTextureParameteri(texture_id, GL_TEXTURE_WRAP_S, wrap_s);
+	glTextureParameteri(texture_id, GL_TEXTURE_WRAP_T, wrap_t);
+	glTextureParameteri(texture_id, GL_TEXTURE_MIN_FILTER, filter_min);
+	glTextureParameteri(texture_id, GL_TEXTURE_MAG_FILTER, filter_max);
+
+	// Is an array texture.
+	is_array_texture = true;
+
+	// Texture is loaded.
+	is_loaded = true;
+}
+
+void Texture2D::GenerateArrayFromLayers(std::uint32_t width, std::uint32_t height, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y, std::uint32_t layer_count, const std::uint8_t* data) {
+
+	AllocateArray(width, height, subimage_size_x, subimage_size_y, layer_count);
+
+	// Every layer in one upload, no slicing needed.
+	if(is_loaded) {
+		UploadLayers(0, layer_count, data);
+	}
+}
+
+void Texture2D::Allocate(std::uint32_t width, std::uint32_t height) {
+
 	if(is_loaded) {
 		std::cout << "Tried to re-generate a texture." << std::endl;
 		return;
@@ -49,7 +276,6 @@ void Texture2D::Generate(std::uint32_t width, std::uint32_t height, std::uint8_t
 	// Create texture.
 	glCreateTextures(GL_TEXTURE_2D, 1, &texture_id);
 	glTextureStorage2D(texture_id, 1, format_internal, width, height);
-	glTextureSubImage2D(texture_id, 0, 0, 0, width, height, format_image, GL_UNSIGNED_BYTE, data);
 
 	// Set texture parameters.
 	glTextureParameteri(texture_id, GL_TEXTURE_WRAP_S, wrap_s);
@@ -64,41 +290,28 @@ void Texture2D::Generate(std::uint32_t width, std::uint32_t height, std::uint8_t
 	is_loaded = true;
 }
 
-void Texture2D::GenerateArray(std::uint32_t width, std::uint32_t height, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y, std::uint8_t* data) {
+void Texture2D::AllocateArray(std::uint32_t width, std::uint32_t height, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y, std::uint32_t layer_count) {
 
 	if(is_loaded) {
 		std::cout << "Tried to re-generate a texture." << std::endl;
 		return;
 	}
 
-	size_t tiles_x = width / subimage_size_x;
-	size_t tiles_y = height / subimage_size_y;
-	size_t tile_count = tiles_x * tiles_y;
-
 	this->width = width;
 	this->height = height;
 	this->subimage_size_x = subimage_size_x;
 	this->subimage_size_y = subimage_size_y;
-	this->subimage_count = tile_count;
+	this->subimage_count = layer_count;
 
 	// Create array texture.
 	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &texture_id);
-	glTextureStorage3D(texture_id, 1, format_internal, subimage_size_x, subimage_size_y, tile_count);
-	
-	// Create temporary helper texture.
-	GLuint temporary_texture = 0;
-	glCreateTextures(GL_TEXTURE_2D, 1, &temporary_texture);
-	glTextureStorage2D(temporary_texture, 1, format_internal, width, height);
-	glTextureSubImage2D(temporary_texture, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	glTextureStorage3D(texture_id, 1, format_internal, subimage_size_x, subimage_size_y, layer_count);
 
-	// Use helper texture to fill main array texture.
-	for(auto i = 0; i < tile_count; i++) {
-		auto x = (i % tiles_x) * subimage_size_x;
-		auto y = (i / tiles_x) * subimage_size_y;
-		glCopyImageSubData(temporary_texture, GL_TEXTURE_2D, 0, x, y, 0, texture_id, GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, subimage_size_x, subimage_size_y, 1);
-	}
-
-	glDeleteTextures(1, &temporary_texture);
+	// Set texture parameters.
+	glTextureParameteri(texture_id, GL_TEXTURE_WRAP_S, wrap_s);
+	glTextureParameteri(texture_id, GL_TEXTURE_WRAP_T, wrap_t);
+	glTextureParameteri(texture_id, GL_TEXTURE_MIN_FILTER, filter_min);
+	glTextureParameteri(texture_id, GL_TEXTURE_MAG_FILTER, filter_max);
 
 	// Is an array texture.
 	is_array_texture = true;
@@ -107,15 +320,116 @@ void Texture2D::GenerateArray(std::uint32_t width, std::uint32_t height, std::ui
 	is_loaded = true;
 }
 
+void Texture2D::UploadRows(std::uint32_t y, std::uint32_t row_count, const std::uint8_t* data) {
+
+	if(is_loaded == false || is_array_texture) {
+		std::cout << "Tried to upload rows to an un-generated or array texture." << std::endl;
+		return;
+	}
+
+	if(IsCompressed()) {
+		glCompressedTextureSubImage2D(texture_id, 0, 0, y, width, row_count, format_internal, GetCompressedImageSize(format_internal, width, row_count), data);
+	} else {
+		glTextureSubImage2D(texture_id, 0, 0, y, width, row_count, format_image, GL_UNSIGNED_BYTE, data);
+	}
+}
+
+void Texture2D::UploadLayers(std::uint32_t first_layer, std::uint32_t layer_count, const std::uint8_t* data) {
+
+	if(is_loaded == false || is_array_texture == false) {
+		std::cout << "Tried to upload layers to an un-generated or non-array texture." << std::endl;
+		return;
+	}
+
+	if(IsCompressed()) {
+		glCompressedTextureSubImage3D(texture_id, 0, 0, 0, first_layer, subimage_size_x, subimage_size_y, layer_count, format_internal, GetCompressedImageSize(format_internal, subimage_size_x, subimage_size_y) * layer_count, data);
+	} else {
+		glTextureSubImage3D(texture_id, 0, 0, 0, first_layer, subimage_size_x, subimage_size_y, layer_count, format_image, GL_UNSIGNED_BYTE, data);
+	}
+}
+
+void Texture2D::Update(std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height, std::uint8_t* data, std::uint32_t row_length) {
+
+	if(is_loaded == false || is_array_texture || IsCompressed()) {
+		std::cout << "Tried to update an un-generated, array or compressed texture." << std::endl;
+		return;
+	}
+
+	// Rows of single channel sub-images aren't 4 byte aligned.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length);
+	glTextureSubImage2D(texture_id, 0, x, y, width, height, format_image, GL_UNSIGNED_BYTE, data);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
 void Texture2D::Delete() {
 	if(is_loaded) {
-		glDeleteTextures(1, &texture_id);
+		RenderState::DeleteTexture(texture_id);
 	}
 }
 
+void Texture2D::SliceTiles(const std::uint8_t* sheet, std::uint32_t sheet_width, std::uint32_t sheet_height, std::uint32_t tile_width, std::uint32_t tile_height, std::uint8_t* layers) {
+
+	size_t tiles_x = sheet_width / tile_width;
+	size_t tile_count = tiles_x * (sheet_height / tile_height);
+
+	size_t thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+
+	if(tile_count * tile_width * tile_height * 4 < parallel_slice_size || thread_count == 1) {
+		SliceTileRange(sheet, sheet_width, tile_width, tile_height, tiles_x, 0, tile_count, layers);
+		return;
+	}
+
+	thread_count = std::min(thread_count, tile_count);
+
+	size_t tiles_per_thread = (tile_count + thread_count - 1) / thread_count;
+	std::vector<std::thread> threads;
+
+	for(size_t tile_begin = 0; tile_begin < tile_count; tile_begin += tiles_per_thread) {
+		threads.emplace_back(SliceTileRange, sheet, sheet_width, tile_width, tile_height, tiles_x, tile_begin, std::min(tile_begin + tiles_per_thread, tile_count), layers);
+	}
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+}
+
+std::vector<TileOpacity> Texture2D::ClassifyTiles(const std::uint8_t* sheet, std::uint32_t sheet_width, std::uint32_t sheet_height, std::uint32_t tile_width, std::uint32_t tile_height) {
+
+	size_t tiles_x = sheet_width / tile_width;
+	size_t tile_count = tiles_x * (sheet_height / tile_height);
+	size_t row_stride = sheet_width * 4;
+
+	std::vector<TileOpacity> opacity(tile_count, TileOpacity::Partial);
+
+	for(size_t tile = 0; tile < tile_count; tile++) {
+		opacity[tile] = ClassifyRegion(sheet + ((tile / tiles_x) * tile_height * row_stride) + ((tile % tiles_x) * tile_width * 4), tile_width, tile_height, row_stride);
+	}
+
+	return opacity;
+}
+
+std::uint32_t Texture2D::GetCompressedBlockSize(std::uint32_t internal_format) {
+	switch(internal_format) {
+		case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+		case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+			return 8;
+		case GL_COMPRESSED_RGBA_BPTC_UNORM:
+		case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+std::uint32_t Texture2D::GetCompressedImageSize(std::uint32_t internal_format, std::uint32_t width, std::uint32_t height) {
+	return ((width + 3) / 4) * ((height + 3) / 4) * GetCompressedBlockSize(internal_format);
+}
+
 void Texture2D::Bind(std::uint32_t texture_unit) {
 	if(is_loaded) {
-		glBindTextureUnit(texture_unit, texture_id);
+		RenderState::BindTexture(texture_unit, texture_id);
 	} else {
 		std::cout << "Tried to bind to un-generated texture." << std::endl;
 	}
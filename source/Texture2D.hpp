@@ -20,6 +20,8 @@
 
 // STL
 #include <cstdint>
+#include <memory>
+#include <vector>
 
 // GLAD2
 #include <glad/gl.h>
@@ -27,16 +29,55 @@
 // SDL2
 #include "SDL.h"
 
+#include "TileOpacity.hpp"
+
+// BC1 is only exposed through GL_EXT_texture_compression_s3tc, which GLAD isn't generated with.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+
 class Texture2D {
 
 	public:
 		Texture2D();
 
+		// With a block compressed internal format (BC1/BC7) data must already be compressed blocks.
 		void Generate(std::uint32_t width, std::uint32_t height, std::uint8_t* data);
-		void GenerateArray(std::uint32_t width, std::uint32_t height, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y, std::uint8_t* data);
+
+		// Slice a sheet of tiles into array layers, uncompressed sheets are uploaded with a single call,
+		// optionally staged through a pixel unpack buffer.
+		void GenerateArray(std::uint32_t width, std::uint32_t height, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y, std::uint8_t* data, bool use_pixel_buffer = false);
+
+		// Generate an array texture from data already laid out one layer after another, i.e. a cooked texture.
+		void GenerateArrayFromLayers(std::uint32_t width, std::uint32_t height, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y, std::uint32_t layer_count, const std::uint8_t* data);
+
+		// Create storage without uploading, then fill it in pieces with UploadRows/UploadLayers.
+		// Compressed rows must start on a multiple of 4. With a pixel unpack buffer bound data is an offset into it.
+		void Allocate(std::uint32_t width, std::uint32_t height);
+		void AllocateArray(std::uint32_t width, std::uint32_t height, std::uint32_t subimage_size_x, std::uint32_t subimage_size_y, std::uint32_t layer_count);
+		void UploadRows(std::uint32_t y, std::uint32_t row_count, const std::uint8_t* data);
+		void UploadLayers(std::uint32_t first_layer, std::uint32_t layer_count, const std::uint8_t* data);
+
+		// Overwrite a region of a generated 2D texture, row_length is in pixels (0 means width).
+		void Update(std::uint32_t x, std::uint32_t y, std::uint32_t width, std::uint32_t height, std::uint8_t* data, std::uint32_t row_length = 0);
 
 		void Delete();
 
+		// Rearrange a tightly packed RGBA8 sheet so every tile is contiguous, in row-major tile order.
+		static void SliceTiles(const std::uint8_t* sheet, std::uint32_t sheet_width, std::uint32_t sheet_height, std::uint32_t tile_width, std::uint32_t tile_height, std::uint8_t* layers);
+
+		// Classify every tile of a tightly packed RGBA8 sheet, in row-major tile order, by its alpha channel.
+		// Layers stored one after another are a sheet one tile wide.
+		static std::vector<TileOpacity> ClassifyTiles(const std::uint8_t* sheet, std::uint32_t sheet_width, std::uint32_t sheet_height, std::uint32_t tile_width, std::uint32_t tile_height);
+
+		// Bytes per 4x4 block of a block compressed format, 0 for uncompressed formats.
+		static std::uint32_t GetCompressedBlockSize(std::uint32_t internal_format);
+		static std::uint32_t GetCompressedImageSize(std::uint32_t internal_format, std::uint32_t width, std::uint32_t height);
+
 		void Bind(std::uint32_t texture_unit = 0);
 
 		void SetFilterMinMax(uint32_t min, uint32_t max) { filter_min = min; filter_max = max; }
@@ -51,6 +92,13 @@ class Texture2D {
 		std::uint32_t GetSubImageCount() { return subimage_count; }
 		bool          IsLoaded()         { return is_loaded; }
 		bool          IsArrayTexture()   { return is_array_texture; }
+		bool          IsCompressed()     { return GetCompressedBlockSize(format_internal) != 0; }
+
+		// Opacity of each subimage as classified on load, shared between copies. Unscanned ones (i.e. compressed) are Partial.
+		void SetSubImageOpacity(std::vector<TileOpacity> opacity) { subimage_opacity = std::make_shared<const std::vector<TileOpacity>>(std::move(opacity)); }
+		TileOpacity GetSubImageOpacity(std::uint32_t index) { return (subimage_opacity != nullptr && index < subimage_opacity->size()) ? (*subimage_opacity)[index] : TileOpacity::Partial; }
+		bool IsSubImageOpaque(std::uint32_t index) { return GetSubImageOpacity(index) == TileOpacity::Opaque; }
+		bool IsSubImageEmpty(std::uint32_t index)  { return GetSubImageOpacity(index) == TileOpacity::Empty; }
 
 	private:
 		// Actual reference to texture.
@@ -75,6 +123,8 @@ class Texture2D {
 
 		// Texture is loaded.
 		bool is_loaded;
+
+		std::shared_ptr<const std::vector<TileOpacity>> subimage_opacity;
 };
 
 #endif /* __TEXTURE_2D_HPP__ */
\ No newline at end of file
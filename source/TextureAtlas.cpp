@@ -0,0 +1,197 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// GLAD2
+#include <glad/gl.h>
+
+#include "Texture2D.hpp"
+#include "TextureAtlas.hpp"
+
+TextureAtlas::TextureAtlas() {
+
+}
+
+void TextureAtlas::AddImage(std::string name, std::uint32_t width, std::uint32_t height, const std::uint8_t* pixels) {
+
+	if(texture.IsLoaded()) {
+		std::cout << "TextureAtlas: Tried to add \"" << name << "\" to an atlas that is already built.\n";
+		return;
+	}
+
+	PendingImage image;
+	image.name = name;
+	image.width = width;
+	image.height = height;
+	image.pixels.assign(pixels, pixels + (width * height * 4));
+	image.x = 0;
+	image.y = 0;
+
+	pending_images.push_back(image);
+}
+
+bool TextureAtlas::Build(bool bilinear, std::uint32_t padding) {
+
+	if(texture.IsLoaded()) {
+		std::cout << "TextureAtlas: Tried to re-build an atlas.\n";
+		return false;
+	}
+
+	if(pending_images.empty()) {
+		return false;
+	}
+
+	// Shelves waste the least space when filled tallest first.
+	std::stable_sort(pending_images.begin(), pending_images.end(), [](const PendingImage& a, const PendingImage& b) {
+		return a.height > b.height;
+	});
+
+	std::uint64_t total_area = 0;
+
+	for(auto& image : pending_images) {
+		total_area += static_cast<std::uint64_t>(image.width + (padding * 2)) * (image.height + (padding * 2));
+	}
+
+	GLint max_texture_size = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+
+	// Start at the smallest power of two square that could hold everything, grow until it packs.
+	std::uint32_t atlas_width = 64;
+	std::uint32_t atlas_height = 64;
+
+	while(static_cast<std::uint64_t>(atlas_width) * atlas_height < total_area) {
+		if(atlas_width <= atlas_height) {
+			atlas_width *= 2;
+		} else {
+			atlas_height *= 2;
+		}
+
+		// Not even the area fits, no need to try packing.
+		if(atlas_width > static_cast<std::uint32_t>(max_texture_size) || atlas_height > static_cast<std::uint32_t>(max_texture_size)) {
+			std::cout << "TextureAtlas: Images don't fit into a " << max_texture_size << "x" << max_texture_size << " texture.\n";
+			return false;
+		}
+	}
+
+	while(true) {
+
+		// Images carry their padding on every side, so the packer itself leaves no gaps.
+		ShelfPacker packer(atlas_width, atlas_height, 0);
+		bool is_packed = true;
+
+		for(auto& image : pending_images) {
+
+			if(packer.Pack(image.width + (padding * 2), image.height + (padding * 2), image.x, image.y) == false) {
+				is_packed = false;
+				break;
+			}
+
+			image.x += padding;
+			image.y += padding;
+		}
+
+		if(is_packed) {
+			break;
+		}
+
+		if(atlas_width <= atlas_height) {
+			atlas_width *= 2;
+		} else {
+			atlas_height *= 2;
+		}
+
+		if(atlas_width > static_cast<std::uint32_t>(max_texture_size) || atlas_height > static_cast<std::uint32_t>(max_texture_size)) {
+			std::cout << "TextureAtlas: Images don't fit into a " << max_texture_size << "x" << max_texture_size << " texture.\n";
+			return false;
+		}
+	}
+
+	std::vector<std::uint8_t> atlas_pixels(atlas_width * atlas_height * 4, 0);
+
+	for(auto& image : pending_images) {
+
+		// Copy the image, then extend its edge pixels out into the padding.
+		for(std::int32_t y = -static_cast<std::int32_t>(padding); y < static_cast<std::int32_t>(image.height + padding); y++) {
+
+			std::int32_t source_y = std::min(std::max(y, 0), static_cast<std::int32_t>(image.height) - 1);
+
+			for(std::int32_t x = -static_cast<std::int32_t>(padding); x < static_cast<std::int32_t>(image.width + padding); x++) {
+
+				std::int32_t source_x = std::min(std::max(x, 0), static_cast<std::int32_t>(image.width) - 1);
+
+				const std::uint8_t* source = &image.pixels[((source_y * image.width) + source_x) * 4];
+				std::uint8_t* destination = &atlas_pixels[(((image.y + y) * atlas_width) + (image.x + x)) * 4];
+
+				std::memcpy(destination, source, 4);
+			}
+		}
+	}
+
+	texture.SetInternalFormat(GL_RGBA8);
+	texture.SetImageFormat(GL_RGBA);
+
+	if(bilinear) {
+		texture.SetFilterMinMax(GL_LINEAR, GL_LINEAR);
+	} else {
+		texture.SetFilterMinMax(GL_NEAREST, GL_NEAREST);
+	}
+
+	texture.Generate(atlas_width, atlas_height, atlas_pixels.data());
+
+	for(auto& image : pending_images) {
+
+		TextureRegion region;
+		region.texture = texture;
+		region.uv_min = glm::vec2(image.x / static_cast<float>(atlas_width), image.y / static_cast<float>(atlas_height));
+		region.uv_max = glm::vec2((image.x + image.width) / static_cast<float>(atlas_width), (image.y + image.height) / static_cast<float>(atlas_height));
+		region.size = glm::vec2(image.width, image.height);
+
+		regions[image.name] = region;
+	}
+
+	pending_images.clear();
+
+	return true;
+}
+
+void TextureAtlas::Delete() {
+	texture.Delete();
+	regions.clear();
+}
+
+bool TextureAtlas::HasRegion(std::string name) {
+	return regions.find(name) != regions.end();
+}
+
+TextureRegion TextureAtlas::GetRegion(std::string name) {
+
+	auto region = regions.find(name);
+
+	if(region == regions.end()) {
+		std::cout << "TextureAtlas: No region named \"" << name << "\".\n";
+		return TextureRegion();
+	}
+
+	return region->second;
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TEXTURE_ATLAS_HPP__
+#define __TEXTURE_ATLAS_HPP__
+
+// STL
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "ShelfPacker.hpp"
+#include "Texture2D.hpp"
+
+// Handle to one image inside an atlas texture.
+struct TextureRegion {
+	Texture2D texture;
+	glm::vec2 uv_min;
+	glm::vec2 uv_max;
+	glm::vec2 size;
+};
+
+/**
+ * Packs many small RGBA images into one Texture2D.
+ *
+ * Images are added by name, Build() packs them onto shelves tallest first and
+ * uploads the result once. Every image is surrounded by padding pixels copied from
+ * its own edge, so bilinear filtering never picks up a neighbour.
+ */
+class TextureAtlas {
+
+	public:
+		TextureAtlas();
+
+		// Pixels are copied, tightly packed RGBA8 rows.
+		void AddImage(std::string name, std::uint32_t width, std::uint32_t height, const std::uint8_t* pixels);
+
+		bool Build(bool bilinear = false, std::uint32_t padding = 1);
+		void Delete();
+
+		bool HasRegion(std::string name);
+		TextureRegion GetRegion(std::string name);
+
+		Texture2D GetTexture() { return texture; }
+		std::uint32_t GetRegionCount() { return static_cast<std::uint32_t>(regions.size()); }
+
+	private:
+		struct PendingImage {
+			std::string name;
+			std::uint32_t width, height;
+			std::vector<std::uint8_t> pixels;
+			std::uint32_t x, y;
+		};
+
+		Texture2D texture;
+
+		std::vector<PendingImage> pending_images;
+		std::map<std::string, TextureRegion> regions;
+};
+
+#endif /* __TEXTURE_ATLAS_HPP__ */
\ No newline at end of file
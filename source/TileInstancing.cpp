@@ -0,0 +1,77 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <cstdint>
+
+// GLAD2
+#include <glad/gl.h>
+
+#include "RenderState.hpp"
+#include "TileInstancing.hpp"
+
+bool TileInstancing::UploadGrowOnly(std::uint32_t& buffer, std::uint32_t& capacity, const void* data, std::uint32_t size, std::uint32_t usage) {
+
+	if(buffer == 0 || size > capacity) {
+
+		if(buffer != 0) {
+			RenderState::DeleteBuffer(buffer);
+		}
+
+		capacity = size;
+
+		glCreateBuffers(1, &buffer);
+		glNamedBufferData(buffer, size, data, usage);
+		return true;
+	}
+
+	if(size > 0) {
+		glNamedBufferSubData(buffer, 0, size, data);
+	}
+
+	return false;
+}
+
+void TileInstancing::CreateQuad(std::uint32_t& vao, std::uint32_t& vbo) {
+
+	// Unit quad, scaled to the tile size in the vertex shader.
+	float vertices[] = {
+		// POS      // TEX
+		0.0f, 1.0f, 0.0f, 1.0f,
+		1.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 0.0f,
+
+		0.0f, 1.0f, 0.0f, 1.0f,
+		1.0f, 1.0f, 1.0f, 1.0f,
+		1.0f, 0.0f, 1.0f, 0.0f
+	};
+
+	glCreateBuffers(1, &vbo);
+	glNamedBufferData(vbo, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+	glCreateVertexArrays(1, &vao);
+
+	// Binding 0: per-vertex quad.
+	glVertexArrayVertexBuffer(vao, 0, vbo, 0, sizeof(float) * 4);
+
+	glEnableVertexArrayAttrib(vao, 0);
+	glVertexArrayAttribFormat(vao, 0, 4, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribBinding(vao, 0, 0);
+
+	// Binding 1: per-instance tile data, one step per instance.
+	glVertexArrayBindingDivisor(vao, 1, 1);
+}
\ No newline at end of file
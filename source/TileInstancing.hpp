@@ -0,0 +1,96 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TILE_INSTANCING_HPP__
+#define __TILE_INSTANCING_HPP__
+
+// STL
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "Camera.hpp"
+#include "GameMapLayer.hpp"
+#include "GameMapTile.hpp"
+#include "Texture2D.hpp"
+
+/**
+ * Building blocks shared by the instanced tile renderers.
+ *
+ * Tile instances are laid out with the tiles whose tileset layer is Opaque first and the
+ * rest after them, so the Opaque and Translucent render passes each draw one contiguous
+ * range. Every tile is drawn as an instance of the same unit quad.
+ */
+class TileInstancing {
+
+	public:
+		// Append an instance for every drawn tile of range, row by row, in two sweeps: the opaque
+		// tiles and then everything else. Each row_offsets gets the first instance of every row
+		// of its sweep plus one past the last row. make_instance(x, y, tile) returns the instance.
+		template<typename Instance, typename MakeInstance>
+		static void AppendOpaqueFirst(GameMapLayer& layer, Texture2D& texture, const TileRange& range, std::vector<Instance>& instances,
+									  std::vector<std::uint32_t>& opaque_row_offsets, std::vector<std::uint32_t>& translucent_row_offsets, MakeInstance make_instance);
+
+		// Upload size bytes into buffer. Only reallocates it when it grows, otherwise overwrites in place.
+		// Returns true when a new buffer was created, which needs attaching again.
+		static bool UploadGrowOnly(std::uint32_t& buffer, std::uint32_t& capacity, const void* data, std::uint32_t size, std::uint32_t usage);
+
+		// Unit quad on binding 0 and attribute 0, binding 1 is left for per-instance data.
+		static void CreateQuad(std::uint32_t& vao, std::uint32_t& vbo);
+
+	private:
+		TileInstancing() { }
+};
+
+template<typename Instance, typename MakeInstance>
+void TileInstancing::AppendOpaqueFirst(GameMapLayer& layer, Texture2D& texture, const TileRange& range, std::vector<Instance>& instances,
+									   std::vector<std::uint32_t>& opaque_row_offsets, std::vector<std::uint32_t>& translucent_row_offsets, MakeInstance make_instance) {
+
+	auto& tiles = layer.GetTiles();
+
+	size_t y_end = std::min<size_t>(range.y_end, tiles.size());
+
+	opaque_row_offsets.clear();
+	translucent_row_offsets.clear();
+
+	for(int part = 0; part < 2; part++) {
+
+		bool want_opaque = (part == 0);
+		std::vector<std::uint32_t>& row_offsets = want_opaque ? opaque_row_offsets : translucent_row_offsets;
+
+		for(size_t y = range.y_begin; y < y_end; y++) {
+			row_offsets.push_back(static_cast<std::uint32_t>(instances.size()));
+
+			size_t x_end = std::min<size_t>(range.x_end, tiles[y].size());
+
+			for(size_t x = range.x_begin; x < x_end; x++) {
+
+				int tileset_index = tiles[y][x].GetTileSetIndex();
+
+				if(tileset_index == 0 || layer.IsTileHidden(x, y) || texture.IsSubImageOpaque(tileset_index) != want_opaque) {
+					continue;
+				}
+
+				instances.push_back(make_instance(x, y, tiles[y][x]));
+			}
+		}
+
+		row_offsets.push_back(static_cast<std::uint32_t>(instances.size()));
+	}
+}
+
+#endif /* __TILE_INSTANCING_HPP__ */
\ No newline at end of file
@@ -0,0 +1,201 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+// GLAD2
+#include <glad/gl.h>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "GameMapLayer.hpp"
+#include "GameMapTile.hpp"
+#include "RenderState.hpp"
+#include "Shader.hpp"
+#include "Texture2D.hpp"
+#include "TileInstancing.hpp"
+#include "TileLayerRenderer.hpp"
+
+TileLayerRenderer::TileLayerRenderer(Shader& shader) : shader(shader) {
+	uniform_origin       = this->shader.GetUniform<glm::vec2>("origin");
+	uniform_tile_size    = this->shader.GetUniform<float>("tile_size");
+	uniform_sprite_color = this->shader.GetUniform<glm::vec3>("spriteColor");
+
+	InitRenderData();
+}
+
+TileLayerRenderer::~TileLayerRenderer() {
+
+	for(auto& batch : batches) {
+		RenderState::DeleteBuffer(batch.second.instance_vbo);
+	}
+
+	RenderState::DeleteVertexArray(quad_vao);
+	RenderState::DeleteBuffer(quad_vbo);
+}
+
+void TileLayerRenderer::DrawLayer(GameMapLayer& layer, Texture2D& texture, glm::vec2 position, glm::vec3 color, const TileRange* visible_tiles, RenderPass pass) {
+
+	if(layer.GetLayerType() != GameMapLayerType::Tiles) {
+		return;
+	}
+
+	if(texture.IsLoaded() == false) {
+		return;
+	}
+
+	if(texture.IsArrayTexture() == false) {
+		return;
+	}
+
+	LayerBatch& batch = batches[&layer];
+
+	// Tile opacity comes from the texture, which changes when a streamed tileset replaces its placeholder.
+	if(batch.is_built == false || batch.revision != layer.GetRevision() || batch.texture_id != texture.GetID()) {
+		RebuildBatch(layer, texture, batch);
+	}
+
+	std::uint32_t opaque_count = batch.opaque_row_offsets.back();
+	std::uint32_t first = (pass == RenderPass::Translucent) ? opaque_count : 0;
+	std::uint32_t last = (pass == RenderPass::Opaque) ? opaque_count : batch.instance_count;
+
+	if(first == last) {
+		return;
+	}
+
+	shader.Use();
+	shader.Set(uniform_origin, position);
+	shader.Set(uniform_tile_size, static_cast<float>(layer.GetTileSize()));
+	shader.Set(uniform_sprite_color, color);
+
+	texture.Bind();
+
+	RenderState::BindVertexArray(quad_vao);
+	glVertexArrayVertexBuffer(quad_vao, 1, batch.instance_vbo, 0, sizeof(TileInstance));
+
+	if(visible_tiles == nullptr) {
+		glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, 6, last - first, first);
+		return;
+	}
+
+	if(pass != RenderPass::Translucent) {
+		DrawVisibleRows(batch, batch.opaque_row_offsets, *visible_tiles);
+	}
+
+	if(pass != RenderPass::Opaque) {
+		DrawVisibleRows(batch, batch.translucent_row_offsets, *visible_tiles);
+	}
+}
+
+void TileLayerRenderer::DrawVisibleRows(LayerBatch& batch, const std::vector<std::uint32_t>& row_offsets, const TileRange& visible_tiles) {
+
+	std::uint32_t row_count = static_cast<std::uint32_t>(row_offsets.size() - 1);
+	std::uint32_t y_end = std::min(visible_tiles.y_end, row_count);
+
+	// Rows whose visible spans touch in the buffer are merged into one draw.
+	std::uint32_t run_begin = 0;
+	std::uint32_t run_end = 0;
+
+	for(std::uint32_t y = visible_tiles.y_begin; y < y_end; y++) {
+
+		auto row_begin = batch.instance_columns.begin() + row_offsets[y];
+		auto row_end = batch.instance_columns.begin() + row_offsets[y + 1];
+
+		std::uint32_t first = static_cast<std::uint32_t>(std::lower_bound(row_begin, row_end, visible_tiles.x_begin) - batch.instance_columns.begin());
+		std::uint32_t last = static_cast<std::uint32_t>(std::lower_bound(row_begin, row_end, visible_tiles.x_end) - batch.instance_columns.begin());
+
+		if(first == last) {
+			continue;
+		}
+
+		if(first != run_end) {
+			if(run_end != run_begin) {
+				glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, 6, run_end - run_begin, run_begin);
+			}
+
+			run_begin = first;
+		}
+
+		run_end = last;
+	}
+
+	if(run_end != run_begin) {
+		glDrawArraysInstancedBaseInstance(GL_TRIANGLES, 0, 6, run_end - run_begin, run_begin);
+	}
+}
+
+void TileLayerRenderer::ReleaseLayer(GameMapLayer& layer) {
+
+	auto batch = batches.find(&layer);
+
+	if(batch == batches.end()) {
+		return;
+	}
+
+	RenderState::DeleteBuffer(batch->second.instance_vbo);
+	batches.erase(batch);
+}
+
+void TileLayerRenderer::RebuildBatch(GameMapLayer& layer, Texture2D& texture, LayerBatch& batch) {
+
+	std::vector<TileInstance> instances;
+	instances.reserve(layer.GetTileCount());
+
+	TileRange whole_layer = { 0, 0, static_cast<std::uint32_t>(layer.GetWidthTiles()), static_cast<std::uint32_t>(layer.GetHeightTiles()) };
+
+	TileInstancing::AppendOpaqueFirst(layer, texture, whole_layer, instances, batch.opaque_row_offsets, batch.translucent_row_offsets, [](size_t x, size_t y, GameMapTile& tile) {
+		TileInstance instance;
+		instance.tile_x = static_cast<std::uint16_t>(x);
+		instance.tile_y = static_cast<std::uint16_t>(y);
+		instance.layer  = static_cast<std::uint16_t>(tile.GetTileSetIndex());
+		instance.flip   = tile.GetFlip();
+		return instance;
+	});
+
+	batch.instance_columns.clear();
+
+	for(auto& instance : instances) {
+		batch.instance_columns.push_back(instance.tile_x);
+	}
+
+	TileInstancing::UploadGrowOnly(batch.instance_vbo, batch.instance_capacity, instances.data(), static_cast<std::uint32_t>(instances.size() * sizeof(TileInstance)), GL_STATIC_DRAW);
+
+	batch.instance_count = static_cast<std::uint32_t>(instances.size());
+	batch.revision = layer.GetRevision();
+	batch.texture_id = texture.GetID();
+	batch.is_built = true;
+}
+
+void TileLayerRenderer::InitRenderData() {
+
+	TileInstancing::CreateQuad(quad_vao, quad_vbo);
+
+	// Binding 1: per-instance tile data, the buffer is attached per layer in DrawLayer.
+	glEnableVertexArrayAttrib(quad_vao, 1);
+	glVertexArrayAttribIFormat(quad_vao, 1, 2, GL_UNSIGNED_SHORT, offsetof(TileInstance, tile_x));
+	glVertexArrayAttribBinding(quad_vao, 1, 1);
+
+	glEnableVertexArrayAttrib(quad_vao, 2);
+	glVertexArrayAttribIFormat(quad_vao, 2, 2, GL_UNSIGNED_SHORT, offsetof(TileInstance, layer));
+	glVertexArrayAttribBinding(quad_vao, 2, 1);
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TILE_LAYER_RENDERER_HPP__
+#define __TILE_LAYER_RENDERER_HPP__
+
+// STL
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "Camera.hpp"
+#include "GameMapLayer.hpp"
+#include "RenderState.hpp"
+#include "Shader.hpp"
+#include "Texture2D.hpp"
+
+/**
+ * Draws an entire Tiles GameMapLayer with a single instanced draw call.
+ *
+ * Each layer gets its own instance buffer holding one TileInstance per non-empty
+ * tile that isn't hidden under an opaque tile. The buffer is only rebuilt when
+ * GameMapLayer::GetRevision() changes.
+ *
+ * Instances are stored row by row, so drawing only the visible TileRange is a handful
+ * of base instance draws, one per run of rows that are contiguous in the buffer.
+ *
+ * Tiles whose tileset layer is Opaque come first in the buffer, the rest after them,
+ * so RenderPass::Opaque and RenderPass::Translucent each draw only their own tiles.
+ */
+class TileLayerRenderer {
+
+	public:
+		TileLayerRenderer(Shader& shader);
+		~TileLayerRenderer();
+
+		void DrawLayer(GameMapLayer& layer, Texture2D& texture, glm::vec2 position = glm::vec2(0.0f), glm::vec3 color = glm::vec3(1.0f), const TileRange* visible_tiles = nullptr, RenderPass pass = RenderPass::All);
+
+		// Drop the cached instance buffer of a layer, i.e. before the layer is destroyed.
+		void ReleaseLayer(GameMapLayer& layer);
+
+		std::uint32_t GetShaderID() { return static_cast<std::uint32_t>(shader.GetID()); }
+
+	private:
+		// Per-instance vertex data, matches the attribute layout set up in InitRenderData.
+		struct TileInstance {
+			std::uint16_t tile_x, tile_y;
+			std::uint16_t layer;
+			std::uint16_t flip;
+		};
+
+		struct LayerBatch {
+			std::uint32_t instance_vbo = 0;
+			std::uint32_t instance_capacity = 0;
+			std::uint32_t instance_count = 0;
+			std::uint32_t revision = 0;
+			std::uint32_t texture_id = 0;
+			bool is_built = false;
+
+			// First instance of each row, plus one past the last row, of the opaque and translucent tiles.
+			std::vector<std::uint32_t> opaque_row_offsets;
+			std::vector<std::uint32_t> translucent_row_offsets;
+			// Column of each instance, sorted within a row.
+			std::vector<std::uint16_t> instance_columns;
+		};
+
+		Shader shader;
+		ShaderUniform<glm::vec2> uniform_origin;
+		ShaderUniform<float>     uniform_tile_size;
+		ShaderUniform<glm::vec3> uniform_sprite_color;
+
+		std::uint32_t quad_vao;
+		std::uint32_t quad_vbo;
+
+		std::map<GameMapLayer*, LayerBatch> batches;
+
+		void InitRenderData();
+		void RebuildBatch(GameMapLayer& layer, Texture2D& texture, LayerBatch& batch);
+		void DrawVisibleRows(LayerBatch& batch, const std::vector<std::uint32_t>& row_offsets, const TileRange& visible_tiles);
+};
+
+#endif /* __TILE_LAYER_RENDERER_HPP__ */
\ No newline at end of file
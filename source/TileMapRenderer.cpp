@@ -0,0 +1,201 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <iostream>
+#include <vector>
+
+// GLAD2
+#include <glad/gl.h>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "GameMapLayer.hpp"
+#include "GameMapTile.hpp"
+#include "RenderState.hpp"
+#include "Shader.hpp"
+#include "Texture2D.hpp"
+#include "TileMapRenderer.hpp"
+
+TileMapRenderer::TileMapRenderer(Shader& shader, Shader& opaque_shader, Shader& translucent_shader) : shader(shader) {
+
+	pass_programs[static_cast<std::uint32_t>(RenderPass::All)].shader = shader;
+	pass_programs[static_cast<std::uint32_t>(RenderPass::Opaque)].shader = opaque_shader;
+	pass_programs[static_cast<std::uint32_t>(RenderPass::Translucent)].shader = translucent_shader;
+
+	for(auto& program : pass_programs) {
+		program.uniform_origin       = program.shader.GetUniform<glm::vec2>("origin");
+		program.uniform_tile_range   = program.shader.GetUniform<glm::vec4>("tile_range");
+		program.uniform_tile_size    = program.shader.GetUniform<float>("tile_size");
+		program.uniform_sprite_color = program.shader.GetUniform<glm::vec3>("spriteColor");
+	}
+
+	InitRenderData();
+}
+
+TileMapRenderer::~TileMapRenderer() {
+
+	for(auto& index_texture : index_textures) {
+		RenderState::DeleteTexture(index_texture.second.texture_id);
+	}
+
+	RenderState::DeleteVertexArray(quad_vao);
+	RenderState::DeleteBuffer(quad_vbo);
+}
+
+void TileMapRenderer::DrawLayer(GameMapLayer& layer, Texture2D& texture, glm::vec2 position, glm::vec3 color, const TileRange* visible_tiles, RenderPass pass) {
+
+	if(layer.GetLayerType() != GameMapLayerType::Tiles) {
+		return;
+	}
+
+	if(texture.IsLoaded() == false) {
+		return;
+	}
+
+	if(texture.IsArrayTexture() == false) {
+		return;
+	}
+
+	if(layer.GetWidthTiles() == 0 || layer.GetHeightTiles() == 0) {
+		return;
+	}
+
+	LayerIndexTexture& index_texture = index_textures[&layer];
+
+	if(index_texture.is_built == false || index_texture.revision != layer.GetRevision()) {
+		UploadLayer(layer, index_texture);
+	}
+
+	// First tile and tile count covered by the quad.
+	glm::vec4 tile_range(0.0f, 0.0f, static_cast<float>(index_texture.width), static_cast<float>(index_texture.height));
+
+	if(visible_tiles != nullptr) {
+		if(visible_tiles->IsEmpty()) {
+			return;
+		}
+
+		tile_range = glm::vec4(visible_tiles->x_begin, visible_tiles->y_begin, visible_tiles->x_end - visible_tiles->x_begin, visible_tiles->y_end - visible_tiles->y_begin);
+	}
+
+	PassProgram& program = pass_programs[static_cast<std::uint32_t>(pass)];
+
+	program.shader.Use();
+	program.shader.Set(program.uniform_origin, position);
+	program.shader.Set(program.uniform_tile_range, tile_range);
+	program.shader.Set(program.uniform_tile_size, static_cast<float>(layer.GetTileSize()));
+	program.shader.Set(program.uniform_sprite_color, color);
+
+	texture.Bind(0);
+	RenderState::BindTexture(1, index_texture.texture_id);
+
+	RenderState::BindVertexArray(quad_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 6);
+}
+
+void TileMapRenderer::ReleaseLayer(GameMapLayer& layer) {
+
+	auto index_texture = index_textures.find(&layer);
+
+	if(index_texture == index_textures.end()) {
+		return;
+	}
+
+	RenderState::DeleteTexture(index_texture->second.texture_id);
+	index_textures.erase(index_texture);
+}
+
+void TileMapRenderer::UploadLayer(GameMapLayer& layer, LayerIndexTexture& index_texture) {
+
+	std::uint32_t width = static_cast<std::uint32_t>(layer.GetWidthTiles());
+	std::uint32_t height = static_cast<std::uint32_t>(layer.GetHeightTiles());
+
+	std::vector<std::uint16_t> indices(width * height, 0);
+
+	auto& tiles = layer.GetTiles();
+
+	for(size_t y = 0; y < tiles.size(); y++) {
+		for(size_t x = 0; x < tiles[y].size(); x++) {
+
+			// Hidden tiles stay 0 and are discarded like empty ones.
+			if(layer.IsTileHidden(x, y)) {
+				continue;
+			}
+
+			std::uint16_t tileset_index = static_cast<std::uint16_t>(tiles[y][x].GetTileSetIndex() & 0x3FFF);
+			std::uint16_t flip = static_cast<std::uint16_t>((tiles[y][x].GetFlip() & 0x3) << 14);
+			indices[(y * width) + x] = tileset_index | flip;
+		}
+	}
+
+	// Storage is immutable, so only recreate the texture if the layer was resized.
+	if(index_texture.texture_id == 0 || index_texture.width != width || index_texture.height != height) {
+
+		if(index_texture.texture_id != 0) {
+			RenderState::DeleteTexture(index_texture.texture_id);
+		}
+
+		glCreateTextures(GL_TEXTURE_2D, 1, &index_texture.texture_id);
+		glTextureStorage2D(index_texture.texture_id, 1, GL_R16UI, width, height);
+
+		// Integer textures can't be filtered.
+		glTextureParameteri(index_texture.texture_id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(index_texture.texture_id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(index_texture.texture_id, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTextureParameteri(index_texture.texture_id, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		index_texture.width = width;
+		index_texture.height = height;
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+	glTextureSubImage2D(index_texture.texture_id, 0, 0, 0, width, height, GL_RED_INTEGER, GL_UNSIGNED_SHORT, indices.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	index_texture.revision = layer.GetRevision();
+	index_texture.is_built = true;
+}
+
+void TileMapRenderer::InitRenderData() {
+
+	// Unit quad, scaled to the layer size in the vertex shader.
+	float vertices[] = {
+		// POS      // TEX
+		0.0f, 1.0f, 0.0f, 1.0f,
+		1.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 0.0f,
+
+		0.0f, 1.0f, 0.0f, 1.0f,
+		1.0f, 1.0f, 1.0f, 1.0f,
+		1.0f, 0.0f, 1.0f, 0.0f
+	};
+
+	glCreateBuffers(1, &quad_vbo);
+	glNamedBufferData(quad_vbo, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+	glCreateVertexArrays(1, &quad_vao);
+
+	glVertexArrayVertexBuffer(quad_vao, 0, quad_vbo, 0, sizeof(float) * 4);
+
+	glEnableVertexArrayAttrib(quad_vao, 0);
+
+	glVertexArrayAttribFormat(quad_vao, 0, 4, GL_FLOAT, GL_FALSE, 0);
+
+	glVertexArrayAttribBinding(quad_vao, 0, 0);
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TILE_MAP_RENDERER_HPP__
+#define __TILE_MAP_RENDERER_HPP__
+
+// STL
+#include <cstdint>
+#include <map>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "Camera.hpp"
+#include "GameMapLayer.hpp"
+#include "RenderState.hpp"
+#include "Shader.hpp"
+#include "Texture2D.hpp"
+
+/**
+ * Draws an entire Tiles GameMapLayer as one quad, independent of the layer size.
+ *
+ * The tile indices of each layer are uploaded once into an R16UI texture which the
+ * fragment shader reads to pick the tileset array layer. The low 14 bits hold the
+ * tileset index, the top two bits hold the GameMapTileFlip bits.
+ *
+ * Given a visible TileRange the quad is shrunk to cover only those tiles.
+ *
+ * The whole layer is one quad, so passes are split per pixel: RenderPass::Opaque draws
+ * with the SHADER_VARIANT_ALPHA_TEST program, keeping pixels with full alpha, and
+ * RenderPass::Translucent with the SHADER_VARIANT_TRANSLUCENT_ONLY one.
+ */
+class TileMapRenderer {
+
+	public:
+		TileMapRenderer(Shader& shader, Shader& opaque_shader, Shader& translucent_shader);
+		~TileMapRenderer();
+
+		void DrawLayer(GameMapLayer& layer, Texture2D& texture, glm::vec2 position = glm::vec2(0.0f), glm::vec3 color = glm::vec3(1.0f), const TileRange* visible_tiles = nullptr, RenderPass pass = RenderPass::All);
+
+		// Drop the cached index texture of a layer, i.e. before the layer is destroyed.
+		void ReleaseLayer(GameMapLayer& layer);
+
+		std::uint32_t GetShaderID() { return static_cast<std::uint32_t>(shader.GetID()); }
+
+	private:
+		struct LayerIndexTexture {
+			std::uint32_t texture_id = 0;
+			std::uint32_t width = 0;
+			std::uint32_t height = 0;
+			std::uint32_t revision = 0;
+			bool is_built = false;
+		};
+
+		// A program and its uniforms, one per RenderPass.
+		struct PassProgram {
+			Shader shader;
+			ShaderUniform<glm::vec2> uniform_origin;
+			ShaderUniform<glm::vec4> uniform_tile_range;
+			ShaderUniform<float>     uniform_tile_size;
+			ShaderUniform<glm::vec3> uniform_sprite_color;
+		};
+
+		Shader shader;
+		PassProgram pass_programs[3];
+
+		std::uint32_t quad_vao;
+		std::uint32_t quad_vbo;
+
+		std::map<GameMapLayer*, LayerIndexTexture> index_textures;
+
+		void InitRenderData();
+		void UploadLayer(GameMapLayer& layer, LayerIndexTexture& index_texture);
+};
+
+#endif /* __TILE_MAP_RENDERER_HPP__ */
\ No newline at end of file
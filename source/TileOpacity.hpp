@@ -0,0 +1,31 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TILE_OPACITY_HPP__
+#define __TILE_OPACITY_HPP__
+
+// STL
+#include <cstdint>
+
+// What the alpha channel of a tile (an array texture layer) holds, found by scanning it on load.
+enum class TileOpacity : std::uint8_t {
+	Partial, // Some pixels are (partially) transparent, or the tile wasn't scanned.
+	Opaque,  // Every pixel has an alpha of 255, blending can be skipped and it hides what's beneath.
+	Empty    // Every pixel has an alpha of 0, it doesn't need drawing at all.
+};
+
+#endif /* __TILE_OPACITY_HPP__ */
\ No newline at end of file
@@ -0,0 +1,350 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// GLAD2
+#include <glad/gl.h>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "Camera.hpp"
+#include "GameMap.hpp"
+#include "GameMapLayer.hpp"
+#include "GameMapTile.hpp"
+#include "GameWorld.hpp"
+#include "RenderState.hpp"
+#include "Shader.hpp"
+#include "Texture2D.hpp"
+#include "TileInstancing.hpp"
+#include "WorldTileRenderer.hpp"
+
+WorldTileRenderer::WorldTileRenderer(Shader& shader) : shader(shader), quad_vao(0), quad_vbo(0), instance_vbo(0), instance_capacity(0), command_buffer(0), command_capacity(0),
+													   are_tilesets_changed(false), built_world(nullptr), tile_size(0.0f),
+													   command_cells_min(0), command_cells_max(0), are_commands_built(false),
+													   visible_command_count(0), draw_call_count(0), command_rebuild_count(0) {
+	uniform_tile_size    = this->shader.GetUniform<float>("tile_size");
+	uniform_depth        = this->shader.GetUniform<float>("depth");
+	uniform_depth_step   = this->shader.GetUniform<float>("depth_step");
+	uniform_sprite_color = this->shader.GetUniform<glm::vec3>("spriteColor");
+
+	InitRenderData();
+}
+
+WorldTileRenderer::~WorldTileRenderer() {
+
+	if(instance_vbo != 0) {
+		RenderState::DeleteBuffer(instance_vbo);
+	}
+
+	if(command_buffer != 0) {
+		RenderState::DeleteBuffer(command_buffer);
+	}
+
+	RenderState::DeleteVertexArray(quad_vao);
+	RenderState::DeleteBuffer(quad_vbo);
+}
+
+void WorldTileRenderer::SetTileSet(const std::string& name, Texture2D& texture) {
+
+	auto found = tileset_indices.find(name);
+
+	if(found == tileset_indices.end()) {
+		tileset_indices[name] = static_cast<std::uint32_t>(tilesets.size());
+		tilesets.push_back(texture);
+		are_tilesets_changed = true;
+		return;
+	}
+
+	// Streamed tilesets replace their placeholder, and with it the tile opacity.
+	if(tilesets[found->second].GetID() != texture.GetID() || tilesets[found->second].IsLoaded() != texture.IsLoaded()) {
+		tilesets[found->second] = texture;
+		are_tilesets_changed = true;
+	}
+}
+
+void WorldTileRenderer::Update(GameWorld& world, Camera& camera) {
+
+	draw_call_count = 0;
+
+	if(are_tilesets_changed || IsWorldChanged(world)) {
+		RebuildChunks(world);
+		are_tilesets_changed = false;
+		are_commands_built = false;
+	}
+
+	float chunk_extent = tile_size * chunk_size;
+
+	if(chunk_extent <= 0.0f) {
+		return;
+	}
+
+	glm::vec2 visible_min = camera.GetVisibleMin();
+	glm::vec2 visible_max = camera.GetVisibleMax();
+
+	glm::ivec2 cells_min(static_cast<int>(std::floor(visible_min.x / chunk_extent)), static_cast<int>(std::floor(visible_min.y / chunk_extent)));
+	glm::ivec2 cells_max(static_cast<int>(std::floor(visible_max.x / chunk_extent)) + 1, static_cast<int>(std::floor(visible_max.y / chunk_extent)) + 1);
+
+	// Camera movement inside the same cells keeps the commands as they are.
+	if(are_commands_built && cells_min.x == command_cells_min.x && cells_min.y == command_cells_min.y && cells_max.x == command_cells_max.x && cells_max.y == command_cells_max.y) {
+		return;
+	}
+
+	RebuildCommands(cells_min, cells_max);
+}
+
+void WorldTileRenderer::Draw(RenderPass pass, float depth, float depth_step) {
+
+	std::vector<CommandBatch>& batches = pass_batches[static_cast<std::uint32_t>(pass)];
+
+	if(batches.empty()) {
+		return;
+	}
+
+	shader.Use();
+	shader.Set(uniform_tile_size, tile_size);
+	shader.Set(uniform_depth, depth);
+	shader.Set(uniform_depth_step, depth_step);
+	shader.Set(uniform_sprite_color, glm::vec3(1.0f));
+
+	RenderState::BindVertexArray(quad_vao);
+	RenderState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+
+	for(auto& batch : batches) {
+		tilesets[batch.tileset].Bind(0);
+
+		std::uintptr_t offset = static_cast<std::uintptr_t>(batch.first_command) * sizeof(DrawArraysIndirectCommand);
+		glMultiDrawArraysIndirect(GL_TRIANGLES, reinterpret_cast<const void*>(offset), static_cast<GLsizei>(batch.command_count), 0);
+
+		draw_call_count++;
+	}
+}
+
+bool WorldTileRenderer::IsWorldChanged(GameWorld& world) {
+
+	if(&world != built_world || static_cast<float>(world.GetTileSize()) != tile_size) {
+		return true;
+	}
+
+	size_t n = 0;
+
+	for(auto& map : world.GetMaps()) {
+		for(auto& layer : map.GetLayers()) {
+			if(n >= built_revisions.size() || built_revisions[n] != layer.GetRevision()) {
+				return true;
+			}
+
+			n++;
+		}
+	}
+
+	return n != built_revisions.size();
+}
+
+void WorldTileRenderer::RebuildChunks(GameWorld& world) {
+
+	std::vector<TileInstance> instances;
+	std::vector<std::uint32_t> opaque_row_offsets;
+	std::vector<std::uint32_t> translucent_row_offsets;
+
+	chunks.clear();
+	built_revisions.clear();
+
+	built_world = &world;
+	tile_size = static_cast<float>(world.GetTileSize());
+
+	float chunk_extent = tile_size * chunk_size;
+
+	for(auto& map : world.GetMaps()) {
+
+		auto& layers = map.GetLayers();
+
+		for(size_t i = 0; i < layers.size(); i++) {
+
+			GameMapLayer& layer = layers[i];
+
+			built_revisions.push_back(layer.GetRevision());
+
+			if(layer.GetLayerType() != GameMapLayerType::Tiles || layer.GetWidthTiles() <= 0 || layer.GetHeightTiles() <= 0 || chunk_extent <= 0.0f) {
+				continue;
+			}
+
+			auto tileset = tileset_indices.find(layer.GetTileSetName());
+
+			if(tileset == tileset_indices.end()) {
+				continue;
+			}
+
+			Texture2D& texture = tilesets[tileset->second];
+
+			if(texture.IsLoaded() == false || texture.IsArrayTexture() == false) {
+				continue;
+			}
+
+			// LDtk lists layers top first, so the last layer is the deepest.
+			std::uint8_t depth_slot = static_cast<std::uint8_t>(std::min<size_t>(layers.size() - 1 - i, 255));
+
+			glm::vec2 origin(static_cast<float>(map.GetWorldX()), static_cast<float>(map.GetWorldY()));
+
+			auto& tiles = layer.GetTiles();
+
+			// Grid cells covered by the layer, half open.
+			int cell_x_begin = static_cast<int>(std::floor(origin.x / chunk_extent));
+			int cell_y_begin = static_cast<int>(std::floor(origin.y / chunk_extent));
+			int cell_x_end = static_cast<int>(std::floor((origin.x + (layer.GetWidthTiles() - 1) * tile_size) / chunk_extent)) + 1;
+			int cell_y_end = static_cast<int>(std::floor((origin.y + (layer.GetHeightTiles() - 1) * tile_size) / chunk_extent)) + 1;
+
+			for(int cell_y = cell_y_begin; cell_y < cell_y_end; cell_y++) {
+
+				// Tiles whose corner falls inside the cell.
+				size_t y_begin = static_cast<size_t>(std::max(0.0f, std::ceil((cell_y * chunk_extent - origin.y) / tile_size)));
+				size_t y_end = std::min(tiles.size(), static_cast<size_t>(std::max(0.0f, std::ceil(((cell_y + 1) * chunk_extent - origin.y) / tile_size))));
+
+				for(int cell_x = cell_x_begin; cell_x < cell_x_end; cell_x++) {
+
+					size_t x_begin = static_cast<size_t>(std::max(0.0f, std::ceil((cell_x * chunk_extent - origin.x) / tile_size)));
+					size_t x_end = static_cast<size_t>(std::max(0.0f, std::ceil(((cell_x + 1) * chunk_extent - origin.x) / tile_size)));
+
+					TileRange cell_tiles = { static_cast<std::uint32_t>(x_begin), static_cast<std::uint32_t>(y_begin), static_cast<std::uint32_t>(x_end), static_cast<std::uint32_t>(y_end) };
+
+					std::uint32_t first_instance = static_cast<std::uint32_t>(instances.size());
+
+					TileInstancing::AppendOpaqueFirst(layer, texture, cell_tiles, instances, opaque_row_offsets, translucent_row_offsets, [&](size_t x, size_t y, GameMapTile& tile) {
+						TileInstance instance;
+						instance.x          = origin.x + x * tile_size;
+						instance.y          = origin.y + y * tile_size;
+						instance.layer      = static_cast<std::uint16_t>(tile.GetTileSetIndex());
+						instance.flip       = tile.GetFlip();
+						instance.depth_slot = depth_slot;
+						return instance;
+					});
+
+					Chunk chunk = { cell_x, cell_y, tileset->second, depth_slot, first_instance,
+									opaque_row_offsets.back() - first_instance, translucent_row_offsets.back() - opaque_row_offsets.back() };
+
+					if(chunk.opaque_count + chunk.translucent_count > 0) {
+						chunks.push_back(chunk);
+					}
+				}
+			}
+		}
+	}
+
+	// A new buffer has to be attached to the vertex array again.
+	if(TileInstancing::UploadGrowOnly(instance_vbo, instance_capacity, instances.data(), static_cast<std::uint32_t>(instances.size() * sizeof(TileInstance)), GL_STATIC_DRAW)) {
+		glVertexArrayVertexBuffer(quad_vao, 1, instance_vbo, 0, sizeof(TileInstance));
+	}
+}
+
+void WorldTileRenderer::RebuildCommands(glm::ivec2 cells_min, glm::ivec2 cells_max) {
+
+	std::vector<std::uint32_t> visible_chunks;
+
+	for(std::uint32_t i = 0; i < chunks.size(); i++) {
+		if(chunks[i].cell_x >= cells_min.x && chunks[i].cell_x < cells_max.x && chunks[i].cell_y >= cells_min.y && chunks[i].cell_y < cells_max.y) {
+			visible_chunks.push_back(i);
+		}
+	}
+
+	// Deepest layers first, then by tileset so the chunks sharing one form a single run.
+	std::sort(visible_chunks.begin(), visible_chunks.end(), [this](std::uint32_t a, std::uint32_t b) {
+		if(chunks[a].depth_slot != chunks[b].depth_slot) {
+			return chunks[a].depth_slot < chunks[b].depth_slot;
+		}
+
+		if(chunks[a].tileset != chunks[b].tileset) {
+			return chunks[a].tileset < chunks[b].tileset;
+		}
+
+		return a < b;
+	});
+
+	std::vector<DrawArraysIndirectCommand> commands;
+
+	// All and Translucent back to front for blending, Opaque front to back for the depth test.
+	for(std::uint32_t pass = 0; pass < 3; pass++) {
+
+		std::vector<CommandBatch>& batches = pass_batches[pass];
+		bool is_front_to_back = (pass == static_cast<std::uint32_t>(RenderPass::Opaque));
+
+		batches.clear();
+
+		for(size_t n = 0; n < visible_chunks.size(); n++) {
+
+			const Chunk& chunk = chunks[visible_chunks[is_front_to_back ? (visible_chunks.size() - 1 - n) : n]];
+
+			std::uint32_t first = chunk.first_instance;
+			std::uint32_t count = chunk.opaque_count + chunk.translucent_count;
+
+			if(pass == static_cast<std::uint32_t>(RenderPass::Opaque)) {
+				count = chunk.opaque_count;
+			} else if(pass == static_cast<std::uint32_t>(RenderPass::Translucent)) {
+				first += chunk.opaque_count;
+				count = chunk.translucent_count;
+			}
+
+			if(count == 0) {
+				continue;
+			}
+
+			if(batches.empty() || batches.back().tileset != chunk.tileset) {
+				batches.push_back({ chunk.tileset, static_cast<std::uint32_t>(commands.size()), 0 });
+			}
+
+			commands.push_back({ 6, count, 0, first });
+			batches.back().command_count++;
+		}
+	}
+
+	TileInstancing::UploadGrowOnly(command_buffer, command_capacity, commands.data(), static_cast<std::uint32_t>(commands.size() * sizeof(DrawArraysIndirectCommand)), GL_DYNAMIC_DRAW);
+
+	visible_command_count = 0;
+
+	for(auto& batch : pass_batches[static_cast<std::uint32_t>(RenderPass::All)]) {
+		visible_command_count += batch.command_count;
+	}
+
+	command_cells_min = cells_min;
+	command_cells_max = cells_max;
+	are_commands_built = true;
+	command_rebuild_count++;
+}
+
+void WorldTileRenderer::InitRenderData() {
+
+	TileInstancing::CreateQuad(quad_vao, quad_vbo);
+
+	// Binding 1: per-instance tile data, the buffer is attached once the chunks are built.
+	glEnableVertexArrayAttrib(quad_vao, 1);
+	glVertexArrayAttribFormat(quad_vao, 1, 2, GL_FLOAT, GL_FALSE, offsetof(TileInstance, x));
+	glVertexArrayAttribBinding(quad_vao, 1, 1);
+
+	glEnableVertexArrayAttrib(quad_vao, 2);
+	glVertexArrayAttribIFormat(quad_vao, 2, 1, GL_UNSIGNED_SHORT, offsetof(TileInstance, layer));
+	glVertexArrayAttribBinding(quad_vao, 2, 1);
+
+	glEnableVertexArrayAttrib(quad_vao, 3);
+	glVertexArrayAttribIFormat(quad_vao, 3, 2, GL_UNSIGNED_BYTE, offsetof(TileInstance, flip));
+	glVertexArrayAttribBinding(quad_vao, 3, 1);
+}
\ No newline at end of file
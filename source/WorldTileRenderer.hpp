@@ -0,0 +1,153 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __WORLD_TILE_RENDERER_HPP__
+#define __WORLD_TILE_RENDERER_HPP__
+
+// STL
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "Camera.hpp"
+#include "GameWorld.hpp"
+#include "RenderState.hpp"
+#include "Shader.hpp"
+#include "Texture2D.hpp"
+
+/**
+ * Draws every Tiles layer of every GameMap in a GameWorld with a few multi-draw indirect calls.
+ *
+ * Tiles are bucketed into chunks of chunk_size by chunk_size tiles on a grid shared by the
+ * whole world, one chunk per layer and grid cell. All chunk instances live in one buffer,
+ * rebuilt only when a layer revision or tileset texture changes, each chunk's opaque tiles
+ * followed by the rest.
+ *
+ * Update() turns the chunks under the camera into DrawArraysIndirectCommands, and only does
+ * so when the camera moves into a different set of grid cells. Draw() then issues one
+ * glMultiDrawArraysIndirect per run of commands sharing a tileset, commands are ordered by
+ * layer so the count doesn't grow with the size of the world.
+ *
+ * Layers are given depth slots, 0 for the deepest layer of a map. With depth testing every
+ * slot is drawn at its own depth, starting at the depth passed to Draw().
+ */
+class WorldTileRenderer {
+
+	public:
+		static const std::uint32_t chunk_size = 16;
+
+		WorldTileRenderer(Shader& shader);
+		~WorldTileRenderer();
+
+		// Tileset texture a GameMapLayer::GetTileSetName() refers to. Setting a different texture rebuilds the chunks.
+		void SetTileSet(const std::string& name, Texture2D& texture);
+
+		// Rebuild the chunks if the world changed, and the commands if the visible chunks did.
+		void Update(GameWorld& world, Camera& camera);
+
+		// depth is the window depth of slot 0, each following slot is depth_step nearer.
+		void Draw(RenderPass pass = RenderPass::All, float depth = 0.0f, float depth_step = 0.0f);
+
+		std::uint32_t GetShaderID() { return static_cast<std::uint32_t>(shader.GetID()); }
+
+		// Statistics.
+		std::uint32_t GetChunkCount()          { return static_cast<std::uint32_t>(chunks.size()); }
+		std::uint32_t GetVisibleCommandCount() { return visible_command_count; }
+		std::uint32_t GetDrawCallCount()       { return draw_call_count; }
+		std::uint32_t GetCommandRebuildCount() { return command_rebuild_count; }
+
+	private:
+		// One tile at its world position, read through binding 1 of quad_vao.
+		struct TileInstance {
+			float x, y;
+			std::uint16_t layer;
+			std::uint8_t flip;
+			std::uint8_t depth_slot;
+		};
+
+		// Matches the layout glMultiDrawArraysIndirect reads.
+		struct DrawArraysIndirectCommand {
+			std::uint32_t count;
+			std::uint32_t instance_count;
+			std::uint32_t first;
+			std::uint32_t base_instance;
+		};
+
+		struct Chunk {
+			std::int32_t cell_x, cell_y;
+			std::uint32_t tileset;
+			std::uint8_t depth_slot;
+			std::uint32_t first_instance;
+			std::uint32_t opaque_count;
+			std::uint32_t translucent_count;
+		};
+
+		// Consecutive commands drawn with the same tileset.
+		struct CommandBatch {
+			std::uint32_t tileset;
+			std::uint32_t first_command;
+			std::uint32_t command_count;
+		};
+
+		Shader shader;
+		ShaderUniform<float>     uniform_tile_size;
+		ShaderUniform<float>     uniform_depth;
+		ShaderUniform<float>     uniform_depth_step;
+		ShaderUniform<glm::vec3> uniform_sprite_color;
+
+		std::uint32_t quad_vao;
+		std::uint32_t quad_vbo;
+		std::uint32_t instance_vbo;
+		std::uint32_t instance_capacity;
+		std::uint32_t command_buffer;
+		std::uint32_t command_capacity;
+
+		std::vector<Texture2D> tilesets;
+		std::map<std::string, std::uint32_t> tileset_indices;
+		bool are_tilesets_changed;
+
+		// What the chunks were built from.
+		GameWorld* built_world;
+		std::vector<std::uint32_t> built_revisions;
+		float tile_size;
+
+		std::vector<Chunk> chunks;
+
+		// Grid cells the commands were built for, half open.
+		glm::ivec2 command_cells_min;
+		glm::ivec2 command_cells_max;
+		bool are_commands_built;
+
+		// Batches of each RenderPass, indexed by its value.
+		std::vector<CommandBatch> pass_batches[3];
+
+		std::uint32_t visible_command_count;
+		std::uint32_t draw_call_count;
+		std::uint32_t command_rebuild_count;
+
+		void InitRenderData();
+		bool IsWorldChanged(GameWorld& world);
+		void RebuildChunks(GameWorld& world);
+		void RebuildCommands(glm::ivec2 cells_min, glm::ivec2 cells_max);
+};
+
+#endif /* __WORLD_TILE_RENDERER_HPP__ */
\ No newline at end of file
@@ -0,0 +1,441 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <strings.h>
+#include <sys/stat.h>
+#endif
+
+// GLAD2
+#include <glad/gl.h>
+
+// SDL2
+#include "SDL.h"
+#include "SDL_main.h"
+#include "SDL_image.h"
+
+// json
+#include <nlohmann/json.hpp>
+
+#include "BC7Encoder.hpp"
+#include "CookedTexture.hpp"
+
+/*
+ * Offline asset cooker.
+ *
+ * Decodes images once and writes them as *.mtex files next to the source, laid out
+ * the way ResourceLoader uploads them (see CookedTexture.hpp). Tilesets are sliced
+ * into array layers here instead of at every launch.
+ *
+ * Usage:
+ *   mattRPG_cooker [--bc7] [--max-error <n>] [--ldtk <project.ldtk>] [--dir <directory>] [--tiles <width> <height> <image>] [<image> ...]
+ *
+ * --ldtk cooks every tileset of an LDtk project as an array texture using its grid size.
+ * --dir cooks every PNG under a directory that has no up to date cooked file. Images cooked
+ * as array textures before are cooked again with the same tile size.
+ * --bc7 compresses the textures that follow to BC7. Pixel art has no gradients to hide
+ * block artifacts in, so a texture is only kept compressed if no channel of any pixel moves
+ * by more than --max-error (default 2), otherwise it is written as RGBA8.
+ */
+
+struct CookSettings {
+	bool compress_bc7;
+	std::uint32_t max_error;
+};
+
+static CookSettings cook_settings = { false, 2 };
+
+static void PrintUsage() {
+	std::cout << "Usage: mattRPG_cooker [--bc7] [--max-error <n>] [--ldtk <project.ldtk>] [--dir <directory>] [--tiles <width> <height> <image>] [<image> ...]\n";
+}
+
+// Replace RGBA8 data with BC7 blocks if the result is close enough to the source.
+static bool CompressTexture(const std::string& filename, CookedTextureHeader& header, std::vector<std::uint8_t>& data) {
+
+	// Layers are contiguous, so the whole array encodes as one tall image as long as tiles are whole blocks.
+	std::uint32_t layer_count = std::max(header.layer_count, 1u);
+
+	if(header.layer_count != 0 && (header.layer_width % 4 != 0 || header.layer_height % 4 != 0)) {
+		std::cout << "Cooker: " << header.layer_width << "x" << header.layer_height << " tiles of \"" << filename << "\" aren't a multiple of 4, keeping RGBA8.\n";
+		return false;
+	}
+
+	std::vector<std::uint8_t> blocks;
+	std::uint32_t max_error = 0;
+
+	if(EncodeBC7(data.data(), header.layer_width, header.layer_height * layer_count, blocks, max_error) == false) {
+		return false;
+	}
+
+	if(max_error > cook_settings.max_error) {
+		std::cout << "Cooker: BC7 changes \"" << filename << "\" by up to " << max_error << ", keeping RGBA8.\n";
+		return false;
+	}
+
+	header.internal_format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+	header.image_type = 0;
+
+	data.swap(blocks);
+
+	return true;
+}
+
+// Decode an image to tightly packed RGBA8 rows.
+static bool DecodeImage(const std::string& filename, std::vector<std::uint8_t>& pixels, std::uint32_t& width, std::uint32_t& height) {
+
+	SDL_Surface* image_surface = IMG_Load(filename.c_str());
+
+	if(image_surface == NULL) {
+		std::cout << "Cooker: Failed to load \"" << filename << "\". IMG_GetError(): " << IMG_GetError() << "\n";
+		return false;
+	}
+
+	SDL_Surface* rgba_surface = SDL_ConvertSurfaceFormat(image_surface, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(image_surface);
+
+	if(rgba_surface == NULL) {
+		std::cout << "Cooker: Failed to convert \"" << filename << "\". SDL_GetError(): " << SDL_GetError() << "\n";
+		return false;
+	}
+
+	width = rgba_surface->w;
+	height = rgba_surface->h;
+	pixels.resize(width * height * 4);
+
+	for(std::uint32_t y = 0; y < height; y++) {
+		std::memcpy(&pixels[y * width * 4], static_cast<std::uint8_t*>(rgba_surface->pixels) + (y * rgba_surface->pitch), width * 4);
+	}
+
+	SDL_FreeSurface(rgba_surface);
+
+	return true;
+}
+
+// Cook an image, as an array texture of tile_width by tile_height layers if both are set.
+static bool CookTexture(const std::string& filename, std::uint32_t tile_width, std::uint32_t tile_height) {
+
+	std::vector<std::uint8_t> pixels;
+	std::uint32_t width = 0;
+	std::uint32_t height = 0;
+
+	CookedTextureHeader header;
+	std::memset(&header, 0, sizeof(header));
+
+	// Stamped before decoding, an edit made while cooking leaves the result stale rather than wrong.
+	if(GetCookedTextureSourceStamp(filename, header.source_size, header.source_modified_time) == false) {
+		std::cout << "Cooker: Failed to read \"" << filename << "\".\n";
+		return false;
+	}
+
+	if(DecodeImage(filename, pixels, width, height) == false) {
+		return false;
+	}
+
+	header.magic = cooked_texture_magic;
+	header.version = cooked_texture_version;
+	header.internal_format = GL_RGBA8;
+	header.image_format = GL_RGBA;
+	header.image_type = GL_UNSIGNED_BYTE;
+	header.source_width = width;
+	header.source_height = height;
+	header.data_offset = sizeof(CookedTextureHeader);
+
+	std::vector<std::uint8_t> data;
+
+	if(tile_width != 0 && tile_height != 0) {
+
+		std::uint32_t tiles_x = width / tile_width;
+		std::uint32_t tiles_y = height / tile_height;
+
+		if(tiles_x == 0 || tiles_y == 0) {
+			std::cout << "Cooker: \"" << filename << "\" is smaller than one " << tile_width << "x" << tile_height << " tile.\n";
+			return false;
+		}
+
+		header.layer_width = tile_width;
+		header.layer_height = tile_height;
+		header.layer_count = tiles_x * tiles_y;
+
+		// Tiles in row-major order, each one contiguous.
+		data.resize(header.layer_count * tile_width * tile_height * 4);
+
+		std::uint8_t* destination = data.data();
+
+		for(std::uint32_t tile = 0; tile < header.layer_count; tile++) {
+
+			std::uint32_t tile_x = (tile % tiles_x) * tile_width;
+			std::uint32_t tile_y = (tile / tiles_x) * tile_height;
+
+			for(std::uint32_t row = 0; row < tile_height; row++) {
+				std::memcpy(destination, &pixels[(((tile_y + row) * width) + tile_x) * 4], tile_width * 4);
+				destination += tile_width * 4;
+			}
+		}
+	} else {
+		header.layer_width = width;
+		header.layer_height = height;
+		header.layer_count = 0;
+
+		data.swap(pixels);
+	}
+
+	if(cook_settings.compress_bc7) {
+		CompressTexture(filename, header, data);
+	}
+
+	header.data_size = data.size();
+
+	std::string cooked_filename = filename + ".mtex";
+	std::ofstream cooked_file(cooked_filename, std::ios::binary | std::ios::trunc);
+
+	if(cooked_file.is_open() == false) {
+		std::cout << "Cooker: Failed to open \"" << cooked_filename << "\" for writing.\n";
+		return false;
+	}
+
+	cooked_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	cooked_file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+	if(cooked_file.good() == false) {
+		std::cout << "Cooker: Failed to write \"" << cooked_filename << "\".\n";
+		return false;
+	}
+
+	std::cout << "Cooker: " << filename << " -> " << cooked_filename << " (" << width << "x" << height;
+
+	if(header.layer_count != 0) {
+		std::cout << ", " << header.layer_count << " layers of " << tile_width << "x" << tile_height;
+	}
+
+	if(header.internal_format == GL_COMPRESSED_RGBA_BPTC_UNORM) {
+		std::cout << ", BC7";
+	}
+
+	std::cout << ")\n";
+
+	return true;
+}
+
+// Cook every tileset referenced by an LDtk project.
+static bool CookLDtkProject(const std::string& filename) {
+
+	std::ifstream input_file(filename);
+
+	if(input_file.is_open() == false) {
+		std::cout << "Cooker: Failed to open \"" << filename << "\".\n";
+		return false;
+	}
+
+	nlohmann::json input_json;
+
+	try {
+		input_file >> input_json;
+	} catch(const std::exception& error) {
+		std::cout << "Cooker: Failed to parse \"" << filename << "\". " << error.what() << "\n";
+		return false;
+	}
+
+	// Tileset paths are relative to the project file.
+	std::string project_directory;
+	size_t separator = filename.find_last_of("/\\");
+
+	if(separator != std::string::npos) {
+		project_directory = filename.substr(0, separator + 1);
+	}
+
+	if(input_json.contains("defs") == false || input_json["defs"].contains("tilesets") == false) {
+		return true;
+	}
+
+	bool success = true;
+
+	for(auto& tileset : input_json["defs"]["tilesets"]) {
+
+		if(tileset.contains("relPath") == false || tileset["relPath"].is_string() == false) {
+			continue;
+		}
+
+		std::uint32_t grid_size = tileset.value("tileGridSize", 16);
+
+		success &= CookTexture(project_directory + tileset["relPath"].get<std::string>(), grid_size, grid_size);
+	}
+
+	return success;
+}
+
+// Collect the PNGs under a directory and its subdirectories.
+static bool FindImages(const std::string& directory, std::vector<std::string>& filenames) {
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA find_data;
+	HANDLE find_handle = FindFirstFileA((directory + "\\*").c_str(), &find_data);
+
+	if(find_handle == INVALID_HANDLE_VALUE) {
+		std::cout << "Cooker: Failed to open directory \"" << directory << "\".\n";
+		return false;
+	}
+
+	do {
+		std::string name = find_data.cFileName;
+
+		if(name == "." || name == "..") {
+			continue;
+		}
+
+		std::string path = directory + "/" + name;
+
+		if(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			FindImages(path, filenames);
+		} else if(name.size() > 4 && _stricmp(name.c_str() + name.size() - 4, ".png") == 0) {
+			filenames.push_back(path);
+		}
+	} while(FindNextFileA(find_handle, &find_data));
+
+	FindClose(find_handle);
+#else
+	DIR* directory_handle = opendir(directory.c_str());
+
+	if(directory_handle == nullptr) {
+		std::cout << "Cooker: Failed to open directory \"" << directory << "\".\n";
+		return false;
+	}
+
+	while(struct dirent* entry = readdir(directory_handle)) {
+		std::string name = entry->d_name;
+
+		if(name == "." || name == "..") {
+			continue;
+		}
+
+		std::string path = directory + "/" + name;
+		struct stat file_status;
+
+		if(stat(path.c_str(), &file_status) != 0) {
+			continue;
+		}
+
+		if(S_ISDIR(file_status.st_mode)) {
+			FindImages(path, filenames);
+		} else if(name.size() > 4 && strcasecmp(name.c_str() + name.size() - 4, ".png") == 0) {
+			filenames.push_back(path);
+		}
+	}
+
+	closedir(directory_handle);
+#endif
+
+	return true;
+}
+
+// Cook every PNG under a directory whose cooked file is missing or out of date.
+static bool CookDirectory(const std::string& directory) {
+
+	std::vector<std::string> filenames;
+
+	if(FindImages(directory, filenames) == false) {
+		return false;
+	}
+
+	std::sort(filenames.begin(), filenames.end());
+
+	bool success = true;
+
+	for(auto& filename : filenames) {
+
+		CookedTextureHeader cooked_header;
+		std::memset(&cooked_header, 0, sizeof(cooked_header));
+
+		std::ifstream cooked_file(filename + ".mtex", std::ios::binary);
+		bool is_cooked = cooked_file.read(reinterpret_cast<char*>(&cooked_header), sizeof(cooked_header)).good() && cooked_header.magic == cooked_texture_magic;
+
+		std::uint64_t source_size = 0;
+		std::int64_t source_modified_time = 0;
+
+		if(is_cooked && cooked_header.version == cooked_texture_version && GetCookedTextureSourceStamp(filename, source_size, source_modified_time) && source_size == cooked_header.source_size && source_modified_time == cooked_header.source_modified_time) {
+			continue;
+		}
+
+		// Tilesets were cooked as array textures, by --ldtk or --tiles, keep them that way. The layer fields sit where they did in older versions.
+		if(is_cooked && cooked_header.layer_count != 0) {
+			success &= CookTexture(filename, cooked_header.layer_width, cooked_header.layer_height);
+		} else {
+			success &= CookTexture(filename, 0, 0);
+		}
+	}
+
+	return success;
+}
+
+int SDL_main(int argc, char** argv) {
+
+	if(argc < 2) {
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+
+	if(IMG_Init(IMG_INIT_PNG) == 0) {
+		std::cout << "Cooker: Failed to initialize SDL_image. IMG_GetError(): " << IMG_GetError() << "\n";
+		return EXIT_FAILURE;
+	}
+
+	bool success = true;
+
+	for(int i = 1; i < argc; i++) {
+
+		std::string argument = argv[i];
+
+		if(argument == "--bc7") {
+			cook_settings.compress_bc7 = true;
+		} else if(argument == "--max-error" && (i + 1) < argc) {
+			cook_settings.max_error = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		} else if(argument == "--ldtk" && (i + 1) < argc) {
+			success &= CookLDtkProject(argv[++i]);
+		} else if(argument == "--dir" && (i + 1) < argc) {
+			success &= CookDirectory(argv[++i]);
+		} else if(argument == "--tiles" && (i + 3) < argc) {
+			std::uint32_t tile_width = static_cast<std::uint32_t>(std::strtoul(argv[i + 1], nullptr, 10));
+			std::uint32_t tile_height = static_cast<std::uint32_t>(std::strtoul(argv[i + 2], nullptr, 10));
+			success &= CookTexture(argv[i + 3], tile_width, tile_height);
+			i += 3;
+		} else if(argument.compare(0, 2, "--") == 0) {
+			PrintUsage();
+			IMG_Quit();
+			return EXIT_FAILURE;
+		} else {
+			success &= CookTexture(argument, 0, 0);
+		}
+	}
+
+	IMG_Quit();
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
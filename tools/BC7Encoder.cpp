@@ -0,0 +1,394 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "BC7Encoder.hpp"
+
+// Interpolation weights of 4-bit indices, out of 64.
+static const int bc7_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static const std::uint32_t bc7_block_size = 16;
+
+// Quantized mode 6 endpoints, a channel decodes to (value << 1) | p_bit.
+struct BC7Endpoints {
+	int values[2][4];
+	int p_bits[2];
+};
+
+struct BC7Candidate {
+	BC7Endpoints endpoints;
+	int indices[16];
+	std::uint64_t error;
+	std::uint32_t max_error;
+};
+
+// Little endian bit writer, BC7 fields are packed starting at the lowest bit.
+class BlockWriter {
+
+	public:
+		BlockWriter(std::uint8_t* block) : block(block), position(0) {
+			std::memset(block, 0, bc7_block_size);
+		}
+
+		void Write(std::uint32_t value, std::uint32_t bits) {
+			for(std::uint32_t i = 0; i < bits; i++, position++) {
+				if((value >> i) & 1) {
+					block[position / 8] |= static_cast<std::uint8_t>(1 << (position % 8));
+				}
+			}
+		}
+
+	private:
+		std::uint8_t* block;
+		std::uint32_t position;
+};
+
+static void QuantizeEndpoint(const float color[4], int values[4], int& p_bit) {
+
+	float best_error = 0.0f;
+
+	for(int p = 0; p < 2; p++) {
+
+		int candidate[4];
+		float error = 0.0f;
+
+		for(int c = 0; c < 4; c++) {
+			candidate[c] = std::min(std::max(static_cast<int>(std::lround((color[c] - p) / 2.0f)), 0), 127);
+
+			float difference = static_cast<float>((candidate[c] << 1) | p) - color[c];
+			error += difference * difference;
+		}
+
+		if(p == 0 || error < best_error) {
+			best_error = error;
+			p_bit = p;
+			std::memcpy(values, candidate, sizeof(candidate));
+		}
+	}
+}
+
+// Pick the closest palette entry for every pixel and measure the result.
+static void EvaluateEndpoints(const std::uint8_t pixels[16][4], BC7Candidate& candidate) {
+
+	int palette[16][4];
+
+	for(int c = 0; c < 4; c++) {
+		int endpoint_0 = (candidate.endpoints.values[0][c] << 1) | candidate.endpoints.p_bits[0];
+		int endpoint_1 = (candidate.endpoints.values[1][c] << 1) | candidate.endpoints.p_bits[1];
+
+		for(int i = 0; i < 16; i++) {
+			palette[i][c] = (((64 - bc7_weights[i]) * endpoint_0) + (bc7_weights[i] * endpoint_1) + 32) >> 6;
+		}
+	}
+
+	candidate.error = 0;
+	candidate.max_error = 0;
+
+	for(int pixel = 0; pixel < 16; pixel++) {
+
+		// The color of a fully transparent pixel never shows.
+		int first_channel = (pixels[pixel][3] == 0) ? 3 : 0;
+
+		std::uint32_t best_error = 0xFFFFFFFF;
+		int best_index = 0;
+
+		for(int i = 0; i < 16; i++) {
+
+			std::uint32_t error = 0;
+
+			for(int c = first_channel; c < 4; c++) {
+				int difference = palette[i][c] - pixels[pixel][c];
+				error += difference * difference;
+			}
+
+			if(error < best_error) {
+				best_error = error;
+				best_index = i;
+			}
+		}
+
+		candidate.indices[pixel] = best_index;
+		candidate.error += best_error;
+
+		for(int c = first_channel; c < 4; c++) {
+			candidate.max_error = std::max(candidate.max_error, static_cast<std::uint32_t>(std::abs(palette[best_index][c] - pixels[pixel][c])));
+		}
+	}
+}
+
+// Solve for the endpoints that best fit the current indices.
+static bool RefineEndpoints(const std::uint8_t pixels[16][4], const BC7Candidate& candidate, float endpoints[2][4]) {
+
+	for(int c = 0; c < 4; c++) {
+
+		float a = 0.0f, b = 0.0f, d = 0.0f, rhs_0 = 0.0f, rhs_1 = 0.0f;
+
+		for(int pixel = 0; pixel < 16; pixel++) {
+
+			if(c < 3 && pixels[pixel][3] == 0) {
+				continue;
+			}
+
+			float t = bc7_weights[candidate.indices[pixel]] / 64.0f;
+			float s = 1.0f - t;
+
+			a += s * s;
+			b += s * t;
+			d += t * t;
+			rhs_0 += s * pixels[pixel][c];
+			rhs_1 += t * pixels[pixel][c];
+		}
+
+		float determinant = (a * d) - (b * b);
+
+		if(std::fabs(determinant) < 1e-6f) {
+			return false;
+		}
+
+		endpoints[0][c] = std::min(std::max(((d * rhs_0) - (b * rhs_1)) / determinant, 0.0f), 255.0f);
+		endpoints[1][c] = std::min(std::max(((a * rhs_1) - (b * rhs_0)) / determinant, 0.0f), 255.0f);
+	}
+
+	return true;
+}
+
+static void TryEndpoints(const std::uint8_t pixels[16][4], float endpoints[2][4], BC7Candidate& best) {
+
+	for(int iteration = 0; iteration < 3; iteration++) {
+
+		BC7Candidate candidate;
+		QuantizeEndpoint(endpoints[0], candidate.endpoints.values[0], candidate.endpoints.p_bits[0]);
+		QuantizeEndpoint(endpoints[1], candidate.endpoints.values[1], candidate.endpoints.p_bits[1]);
+
+		EvaluateEndpoints(pixels, candidate);
+
+		if(candidate.error < best.error) {
+			best = candidate;
+		}
+
+		if(candidate.error == 0 || RefineEndpoints(pixels, candidate, endpoints) == false) {
+			break;
+		}
+	}
+}
+
+static void EncodeBlock(const std::uint8_t pixels[16][4], std::uint8_t* block, std::uint32_t& max_error) {
+
+	// Transparent pixels take the average opaque color so they don't pull the axis around.
+	float opaque_mean[3] = { 0.0f, 0.0f, 0.0f };
+	int opaque_count = 0;
+
+	for(int pixel = 0; pixel < 16; pixel++) {
+		if(pixels[pixel][3] != 0) {
+			for(int c = 0; c < 3; c++) {
+				opaque_mean[c] += pixels[pixel][c];
+			}
+			opaque_count++;
+		}
+	}
+
+	for(int c = 0; c < 3 && opaque_count != 0; c++) {
+		opaque_mean[c] /= opaque_count;
+	}
+
+	float colors[16][4];
+	float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	for(int pixel = 0; pixel < 16; pixel++) {
+		for(int c = 0; c < 4; c++) {
+			colors[pixel][c] = (c < 3 && pixels[pixel][3] == 0) ? opaque_mean[c] : pixels[pixel][c];
+			mean[c] += colors[pixel][c] / 16.0f;
+		}
+	}
+
+	BC7Candidate best;
+	best.error = ~0ull;
+
+	// Bounding box corners.
+	float endpoints[2][4];
+
+	for(int c = 0; c < 4; c++) {
+		endpoints[0][c] = 255.0f;
+		endpoints[1][c] = 0.0f;
+
+		for(int pixel = 0; pixel < 16; pixel++) {
+			endpoints[0][c] = std::min(endpoints[0][c], colors[pixel][c]);
+			endpoints[1][c] = std::max(endpoints[1][c], colors[pixel][c]);
+		}
+	}
+
+	TryEndpoints(pixels, endpoints, best);
+
+	// Extremes along the principal axis, found by power iteration on the covariance.
+	float covariance[4][4] = { };
+
+	for(int pixel = 0; pixel < 16; pixel++) {
+		for(int i = 0; i < 4; i++) {
+			for(int j = 0; j < 4; j++) {
+				covariance[i][j] += (colors[pixel][i] - mean[i]) * (colors[pixel][j] - mean[j]);
+			}
+		}
+	}
+
+	float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	for(int iteration = 0; iteration < 8; iteration++) {
+
+		float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+		for(int i = 0; i < 4; i++) {
+			for(int j = 0; j < 4; j++) {
+				next[i] += covariance[i][j] * axis[j];
+			}
+		}
+
+		float length = std::sqrt((next[0] * next[0]) + (next[1] * next[1]) + (next[2] * next[2]) + (next[3] * next[3]));
+
+		if(length < 1e-6f) {
+			break;
+		}
+
+		for(int i = 0; i < 4; i++) {
+			axis[i] = next[i] / length;
+		}
+	}
+
+	if(best.error != 0) {
+
+		float t_min = 0.0f, t_max = 0.0f;
+
+		for(int pixel = 0; pixel < 16; pixel++) {
+			float t = 0.0f;
+
+			for(int c = 0; c < 4; c++) {
+				t += (colors[pixel][c] - mean[c]) * axis[c];
+			}
+
+			t_min = std::min(t_min, t);
+			t_max = std::max(t_max, t);
+		}
+
+		for(int c = 0; c < 4; c++) {
+			endpoints[0][c] = std::min(std::max(mean[c] + (t_min * axis[c]), 0.0f), 255.0f);
+			endpoints[1][c] = std::min(std::max(mean[c] + (t_max * axis[c]), 0.0f), 255.0f);
+		}
+
+		TryEndpoints(pixels, endpoints, best);
+	}
+
+	// The first index is stored with an implicit zero top bit, swap the endpoints if needed.
+	if(best.indices[0] >= 8) {
+		std::swap(best.endpoints.values[0], best.endpoints.values[1]);
+		std::swap(best.endpoints.p_bits[0], best.endpoints.p_bits[1]);
+
+		for(int pixel = 0; pixel < 16; pixel++) {
+			best.indices[pixel] = 15 - best.indices[pixel];
+		}
+	}
+
+	BlockWriter writer(block);
+
+	// Mode 6 is six zero bits followed by a one.
+	writer.Write(1 << 6, 7);
+
+	for(int c = 0; c < 4; c++) {
+		writer.Write(best.endpoints.values[0][c], 7);
+		writer.Write(best.endpoints.values[1][c], 7);
+	}
+
+	writer.Write(best.endpoints.p_bits[0], 1);
+	writer.Write(best.endpoints.p_bits[1], 1);
+
+	writer.Write(best.indices[0], 3);
+
+	for(int pixel = 1; pixel < 16; pixel++) {
+		writer.Write(best.indices[pixel], 4);
+	}
+
+	max_error = std::max(max_error, best.max_error);
+}
+
+static void EncodeBlockRows(const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height, std::uint32_t row_begin, std::uint32_t row_end, std::uint8_t* blocks, std::uint32_t* max_error) {
+
+	std::uint32_t blocks_x = (width + 3) / 4;
+
+	for(std::uint32_t block_y = row_begin; block_y < row_end; block_y++) {
+		for(std::uint32_t block_x = 0; block_x < blocks_x; block_x++) {
+
+			// Edge blocks repeat the last row and column.
+			std::uint8_t block_pixels[16][4];
+
+			for(std::uint32_t y = 0; y < 4; y++) {
+				std::uint32_t source_y = std::min((block_y * 4) + y, height - 1);
+
+				for(std::uint32_t x = 0; x < 4; x++) {
+					std::uint32_t source_x = std::min((block_x * 4) + x, width - 1);
+					std::memcpy(block_pixels[(y * 4) + x], &pixels[((source_y * width) + source_x) * 4], 4);
+				}
+			}
+
+			EncodeBlock(block_pixels, &blocks[((block_y * blocks_x) + block_x) * bc7_block_size], *max_error);
+		}
+	}
+}
+
+bool EncodeBC7(const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height, std::vector<std::uint8_t>& blocks, std::uint32_t& max_error, std::uint32_t thread_count) {
+
+	if(width == 0 || height == 0) {
+		return false;
+	}
+
+	std::uint32_t blocks_x = (width + 3) / 4;
+	std::uint32_t blocks_y = (height + 3) / 4;
+
+	blocks.resize(blocks_x * blocks_y * bc7_block_size);
+
+	if(thread_count == 0) {
+		thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	thread_count = std::min(thread_count, blocks_y);
+
+	std::vector<std::thread> threads;
+	std::vector<std::uint32_t> thread_max_errors(thread_count, 0);
+
+	std::uint32_t rows_per_thread = (blocks_y + thread_count - 1) / thread_count;
+
+	for(std::uint32_t i = 0; i < thread_count; i++) {
+		std::uint32_t row_begin = i * rows_per_thread;
+		std::uint32_t row_end = std::min(row_begin + rows_per_thread, blocks_y);
+
+		threads.emplace_back(EncodeBlockRows, pixels, width, height, row_begin, row_end, blocks.data(), &thread_max_errors[i]);
+	}
+
+	max_error = 0;
+
+	for(std::uint32_t i = 0; i < thread_count; i++) {
+		threads[i].join();
+		max_error = std::max(max_error, thread_max_errors[i]);
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+/**
+ * This file is part of mattRPG.
+ *
+ * mattRPG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * mattRPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with mattRPG.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BC7_ENCODER_HPP__
+#define __BC7_ENCODER_HPP__
+
+// STL
+#include <cstdint>
+#include <vector>
+
+/**
+ * CPU encoder for BC7 (GL_COMPRESSED_RGBA_BPTC_UNORM), used by the cooker.
+ *
+ * Every block is written in mode 6: one subset, RGBA endpoints with a p-bit and
+ * sixteen interpolated colors. That represents the flat runs and two tone edges of
+ * pixel art closely, and is cheap enough to search well. Endpoints start from the
+ * principal axis and the bounding box of the block and are refined by least squares.
+ * Fully transparent pixels only constrain alpha.
+ *
+ * Blocks are split between threads by rows. max_error returns the largest per-channel
+ * difference between any source and decoded pixel so the caller can reject lossy results.
+ */
+bool EncodeBC7(const std::uint8_t* pixels, std::uint32_t width, std::uint32_t height, std::vector<std::uint8_t>& blocks, std::uint32_t& max_error, std::uint32_t thread_count = 0);
+
+#endif /* __BC7_ENCODER_HPP__ */
\ No newline at end of file